@@ -1,8 +1,13 @@
 #include "handlers.hpp"
 #include "../Config/config.hpp"
 #include "../Migrator/migrator.hpp"
-#include <print>
+#include "../Logger/logger.hpp"
+#include <algorithm>
+#include <charconv>
 #include <cstdlib>
+#include <map>
+#include <optional>
+#include <string>
 #include <string_view>
 
 namespace {
@@ -12,10 +17,65 @@ namespace {
         if (result) {
             return *result;
         } else {
-            std::println("Failed to load environment variables");
+            logger::error("Failed to load environment variables");
             std::exit(EXIT_FAILURE);
         }
     }
+
+    // Whole-string integer parse: "10abc" or "" are rejected, not read as 10 / 0
+    std::optional<int> parseInt(std::string_view value) {
+        int result = 0;
+        auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (ec != std::errc{} || ptr != value.data() + value.size()) return std::nullopt;
+        return result;
+    }
+
+    bool hasFlag(std::span<std::string_view> args, std::string_view flag) {
+        return std::ranges::find(args, flag) != args.end();
+    }
+
+    // TAMA_ENV labels the run history, so timings from staging and production can be compared
+    std::string envNameHelper(const std::map<std::string, std::string>& env) {
+        return env.contains("TAMA_ENV") ? env.at("TAMA_ENV") : "default";
+    }
+
+    // Post-migration maintenance: on by default, tuned with TAMA_MAINTENANCE_* keys,
+    // and skipped for a single run with --no-maintenance
+    MaintenanceOptions maintenanceHelper(const std::map<std::string, std::string>& env,
+                                         std::span<std::string_view> args) {
+        MaintenanceOptions options;
+        auto flag = [&](const char* key, bool& field) {
+            if (env.contains(key)) field = config::is_true(env.at(key));
+        };
+
+        flag("TAMA_MAINTENANCE", options.enabled);
+        flag("TAMA_MAINTENANCE_ANALYZE", options.analyze);
+        flag("TAMA_MAINTENANCE_OPTIMIZE", options.optimize);
+        flag("TAMA_MAINTENANCE_CHECKPOINT", options.checkpoint);
+
+        // Page and row budgets: non-negative integers, 0 meaning "skip" / "no limit"
+        auto budget = [&](const char* key, int& field) {
+            if (!env.contains(key)) return;
+            auto parsed = parseInt(env.at(key));
+            if (parsed && *parsed >= 0) {
+                field = *parsed;
+            } else {
+                logger::warn("Warning: Ignoring invalid {} '{}'", key, env.at(key));
+            }
+        };
+
+        budget("TAMA_MAINTENANCE_VACUUM_PAGES", options.vacuum_pages);
+        budget("TAMA_MAINTENANCE_ANALYSIS_LIMIT", options.analysis_limit);
+
+        if (hasFlag(args, "--no-maintenance")) options.enabled = false;
+        return options;
+    }
+
+    // Snapshots go to TAMA_BACKUP_DIR, or next to the database file by default
+    std::string backupDirHelper(const std::map<std::string, std::string>& env) {
+        if (env.contains("TAMA_BACKUP_DIR")) return env.at("TAMA_BACKUP_DIR");
+        return env.at("TAMA_DB_CONNECTION_STRING") + ".backups";
+    }
 }
 
 namespace commands {
@@ -23,13 +83,13 @@ namespace commands {
     // 1. Validate specific args for this command
     // We expect: [migration_name]
         if (args.empty()) {
-            std::println("Error: 'init' requires a migration name.");
-            std::println("Usage: tama init <migration_name>");
+            logger::error("Error: 'init' requires a migration name.");
+            logger::print("Usage: tama init <migration_name>");
             std::exit(EXIT_FAILURE);
         }
 
         std::string_view migration_name = args[0];
-        std::println("Creating sql migration: {}", migration_name);
+        logger::info("Creating sql migration: {}", migration_name);
 
     // 2. Load Env
         const auto& env = loadEnvHelper(".env");
@@ -39,54 +99,138 @@ namespace commands {
             Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"));
             migrator.generate_migration(migration_name);
         } else {
-            std::println("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
+            logger::error("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
         }
     }
 
     void handle_up(std::span<std::string_view> args) {
     // 1. Load Env
         const auto& env = loadEnvHelper(".env");
+        bool ok = true;
         if (env.contains("TAMA_DB_MIGRATION_DIR") && env.contains("TAMA_DB_ENGINE")) {
             // Construct the Migrator
             // Note: converting string_view to string for the constructor if needed
-            Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"));
-            migrator.up();
+            Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"),
+                              envNameHelper(env));
+            if (hasFlag(args, "--backup")) {
+                migrator.enable_backups(backupDirHelper(env));
+            }
+            migrator.set_maintenance(maintenanceHelper(env, args));
+            ok = migrator.up();
         } else {
-            std::println("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
+            logger::error("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
         }
+
+        // Exit only after the Migrator went out of scope and closed the DB
+        if (!ok) std::exit(EXIT_FAILURE);
     }
 
     void handle_down(std::span<std::string_view> args) {
     // 1. Load Env
         const auto& env = loadEnvHelper(".env");
+        bool ok = true;
         if (env.contains("TAMA_DB_MIGRATION_DIR") && env.contains("TAMA_DB_ENGINE")) {
             // Construct the Migrator
             // Note: converting string_view to string for the constructor if needed
-            Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"));
-            migrator.down();
+            Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"),
+                              envNameHelper(env));
+            if (hasFlag(args, "--backup")) {
+                migrator.enable_backups(backupDirHelper(env));
+            }
+            migrator.set_maintenance(maintenanceHelper(env, args));
+            ok = migrator.down();
         } else {
-            std::println("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
+            logger::error("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
         }
+
+        // Exit only after the Migrator went out of scope and closed the DB
+        if (!ok) std::exit(EXIT_FAILURE);
     }
 
     void handle_reset(std::span<std::string_view> args) {
     // 1. Load Env
         const auto& env = loadEnvHelper(".env");
+        bool ok = true;
         if (env.contains("TAMA_DB_MIGRATION_DIR") && env.contains("TAMA_DB_ENGINE")) {
             // Construct the Migrator
             // Note: converting string_view to string for the constructor if needed
+            Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"),
+                              envNameHelper(env));
+            if (hasFlag(args, "--backup")) {
+                migrator.enable_backups(backupDirHelper(env));
+            }
+            migrator.set_maintenance(maintenanceHelper(env, args));
+            ok = migrator.reset();
+        } else {
+            logger::error("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
+        }
+
+        // Exit only after the Migrator went out of scope and closed the DB
+        if (!ok) std::exit(EXIT_FAILURE);
+    }
+
+    void handle_restore(std::span<std::string_view> args) {
+    // 1. Load Env
+    // We accept: [snapshot_path] (defaults to the latest snapshot)
+        const auto& env = loadEnvHelper(".env");
+        bool ok = true;
+        if (env.contains("TAMA_DB_MIGRATION_DIR") && env.contains("TAMA_DB_ENGINE")) {
             Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"));
-            migrator.reset();
+            std::string_view snapshot = args.empty() ? std::string_view{} : args[0];
+            ok = migrator.restore(backupDirHelper(env), snapshot);
+        } else {
+            logger::error("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
+        }
+
+        // Exit only after the Migrator went out of scope and closed the DB
+        if (!ok) std::exit(EXIT_FAILURE);
+    }
+
+    void handle_stats(std::span<std::string_view> args) {
+    // 1. Parse options
+    // We accept: [--limit N] [--compare <other_db>]
+        int limit = 10;
+        std::string_view compare_db;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "--limit" && i + 1 < args.size()) {
+                auto value = args[++i];
+                auto parsed = parseInt(value);
+                if (!parsed || *parsed <= 0) {
+                    logger::error("Error: --limit expects a positive number, got '{}'", value);
+                    std::exit(EXIT_FAILURE);
+                }
+                limit = *parsed;
+            } else if (args[i] == "--compare" && i + 1 < args.size()) {
+                compare_db = args[++i];
+            } else {
+                logger::error("Error: Unknown option '{}' for 'stats'.", args[i]);
+                logger::error("Usage: tama stats [--limit N] [--compare <other_db>]");
+                std::exit(EXIT_FAILURE);
+            }
+        }
+
+    // 2. Load Env
+        const auto& env = loadEnvHelper(".env");
+        if (env.contains("TAMA_DB_MIGRATION_DIR") && env.contains("TAMA_DB_ENGINE")) {
+            Migrator migrator(env.at("TAMA_DB_MIGRATION_DIR"), env.at("TAMA_DB_CONNECTION_STRING"), env.at("TAMA_DB_ENGINE"),
+                              envNameHelper(env));
+            migrator.stats(limit, compare_db);
         } else {
-            std::println("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
+            logger::error("Error: .env missing TAMA_DB_MIGRATION_DIR or TAMA_DB_ENGINE");
         }
     }
 
     void handle_help(std::span<std::string_view> args) {
-    std::println("Available commands:");
-    std::println("  init <migration_name>   Create a new migration");
-    std::println("  up            Run pending migrations");
-    std::println("  down            Drop the last applied migrations");
-    std::println("  reset         Drop all applied migrations");
+    logger::print("Available commands:");
+    logger::print("  init <migration_name>   Create a new migration");
+    logger::print("  up            Run pending migrations");
+    logger::print("  down            Drop the last applied migrations");
+    logger::print("  reset         Drop all applied migrations");
+    logger::print("  restore [snapshot]   Restore a backup (default: the latest)");
+    logger::print("  stats [--limit N] [--compare <db>]   Slowest migrations and per-environment timings");
+    logger::print("");
+    logger::print("Options for up/down/reset:");
+    logger::print("  --backup      Snapshot the database before migrating");
+    logger::print("  --no-maintenance   Skip ANALYZE/optimize/vacuum/checkpoint after migrating");
     }
 }
\ No newline at end of file
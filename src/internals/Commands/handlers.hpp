@@ -9,5 +9,7 @@ namespace commands {
     void handle_up(std::span<std::string_view> args);
     void handle_down(std::span<std::string_view> args);
     void handle_reset(std::span<std::string_view> args);
+    void handle_restore(std::span<std::string_view> args);
+    void handle_stats(std::span<std::string_view> args);
     void handle_help(std::span<std::string_view> args);
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "config.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <expected>
 #include <fstream>
 #include <string>
@@ -41,4 +44,13 @@ namespace config {
 
         return env_map;;
     }
+
+    bool is_true(std::string_view value) {
+        constexpr std::array<std::string_view, 4> truthy{"true", "1", "on", "yes"};
+        return std::ranges::any_of(truthy, [value](std::string_view word) {
+            return std::ranges::equal(trim(value), word, [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) == b;
+            });
+        });
+    }
 }
\ No newline at end of file
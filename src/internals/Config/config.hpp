@@ -3,6 +3,7 @@
 #include <expected>
 #include <map>
 #include <string>
+#include <string_view>
 
 namespace config {
     enum class ParseError { FileNotFound, InvalidFormat };
@@ -11,4 +12,7 @@ namespace config {
     // Returns a map on success or a ParseError on failure
     std::expected<std::map<std::string, std::string>, ParseError>
     load_env(const std::string &filename);
+
+    // Boolean .env values: true / 1 / on / yes, in any case. Anything else is false.
+    bool is_true(std::string_view value);
 } // namespace config
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "backup.hpp"
+
+#include <sqlite3.h>
+
+#include "logger.hpp"
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <system_error>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+Backup::Backup(sqlite3* database, std::string directory, int pages, int busy_timeout)
+    : db(database),
+      backup_dir(std::move(directory)),
+      pages_per_step(pages > 0 ? pages : 256),
+      busy_timeout_ms(busy_timeout > 0 ? busy_timeout : 5000) {}
+
+// The page-copy loop shared by create() and restore()
+bool Backup::copy(sqlite3* source, sqlite3* dest, int pages) {
+    sqlite3_backup* backup = sqlite3_backup_init(dest, "main", source, "main");
+    if (!backup) {
+        logger::error("Backup Init Error: {}", sqlite3_errmsg(dest));
+        return false;
+    }
+
+    // Each step copies a batch of pages and then lets go of the source lock.
+    // BUSY/LOCKED just means someone else holds it right now: wait briefly and retry,
+    // but only for busy_timeout_ms in a row, so a long-lived reader cannot hang us.
+    constexpr int retry_sleep_ms = 5;
+    int waited_ms = 0;
+
+    // A write from another connection makes the next step start over from page 1
+    // (the remaining count jumps back up). With steady writes that never ends, so after
+    // a few restarts the rest is copied in one step, holding the read lock until done.
+    constexpr int max_restarts = 3;
+    int restarts = 0;
+    int last_remaining = -1;
+
+    int rc;
+    do {
+        rc = sqlite3_backup_step(backup, pages);
+        if (rc == SQLITE_OK) {
+            waited_ms = 0;
+            int remaining = sqlite3_backup_remaining(backup);
+            if (last_remaining >= 0 && remaining > last_remaining && ++restarts >= max_restarts && pages > 0) {
+                logger::warn("Warning: Database changed {} times during the backup, copying it in one step",
+                             restarts);
+                pages = -1;
+            }
+            last_remaining = remaining;
+            logger::debug("Backup progress: {}/{} pages left", remaining, sqlite3_backup_pagecount(backup));
+        } else if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+            if (waited_ms >= busy_timeout_ms) break;
+            sqlite3_sleep(retry_sleep_ms);
+            waited_ms += retry_sleep_ms;
+        }
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+    // finish() releases the backup object; it also reports errors from the last step
+    sqlite3_backup_finish(backup);
+
+    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        logger::error("Backup Error: database stayed locked for {} ms, giving up", busy_timeout_ms);
+        return false;
+    }
+    if (rc != SQLITE_DONE) {
+        logger::error("Backup Error: {}", sqlite3_errstr(rc));
+        return false;
+    }
+    return true;
+}
+
+// CREATE: Snapshot
+std::optional<std::string> Backup::create(std::string_view version) {
+    std::error_code ec;
+    fs::create_directories(backup_dir, ec);
+    if (ec) {
+        logger::error("Error: Could not create backup directory {}: {}", backup_dir, ec.message());
+        return std::nullopt;
+    }
+
+    auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+    std::string final_path = std::format("{}/{}_{:%Y%m%d%H%M%S}.db", backup_dir, version, now);
+
+    // Write to a temp name first, so a crash never leaves a half-written snapshot
+    // that latest() would pick up.
+    std::string partial_path = final_path + ".partial";
+
+    sqlite3* dest = nullptr;
+    if (sqlite3_open(partial_path.c_str(), &dest) != SQLITE_OK) {
+        logger::error("Error: Could not open snapshot {}: {}", partial_path,
+                      dest ? sqlite3_errmsg(dest) : "Memory allocation failed");
+        sqlite3_close(dest);
+        return std::nullopt;
+    }
+
+    bool ok = copy(db, dest, pages_per_step);
+    sqlite3_close(dest);
+
+    if (!ok) {
+        fs::remove(partial_path, ec);
+        return std::nullopt;
+    }
+
+    fs::rename(partial_path, final_path, ec);
+    if (ec) {
+        logger::error("Error: Could not finalize snapshot {}: {}", final_path, ec.message());
+        fs::remove(partial_path, ec);
+        return std::nullopt;
+    }
+
+    return final_path;
+}
+
+// RESTORE: Swap a snapshot back in
+bool Backup::restore(const std::string& snapshot_path) {
+    if (!fs::exists(snapshot_path)) {
+        logger::error("Error: Snapshot {} does not exist", snapshot_path);
+        return false;
+    }
+
+    sqlite3* source = nullptr;
+    if (sqlite3_open_v2(snapshot_path.c_str(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        logger::error("Error: Could not open snapshot {}: {}", snapshot_path,
+                      source ? sqlite3_errmsg(source) : "Memory allocation failed");
+        sqlite3_close(source);
+        return false;
+    }
+
+    // -1 copies every page in one step, i.e. inside a single write transaction
+    // on the live DB. Other connections see either the old or the restored DB.
+    bool ok = copy(source, db, -1);
+    sqlite3_close(source);
+    return ok;
+}
+
+// READ: Latest snapshot
+std::optional<std::string> Backup::latest() const {
+    std::error_code ec;
+    if (!fs::is_directory(backup_dir, ec)) return std::nullopt;
+
+    // Names are '<version>_<YYYYMMDDHHMMSS>.db'; the fixed-width timestamp sorts chronologically.
+    // Two snapshots taken within the same second are told apart by file mtime.
+    auto taken_at = [](const fs::directory_entry& entry) {
+        std::string stem = entry.path().stem().string();
+        auto sep = stem.rfind('_');
+        std::error_code mtime_ec;
+        return std::pair{sep == std::string::npos ? std::string{} : stem.substr(sep + 1),
+                         entry.last_write_time(mtime_ec)};
+    };
+
+    std::optional<std::string> newest;
+    std::pair<std::string, fs::file_time_type> newest_time;
+    for (const auto& entry : fs::directory_iterator(backup_dir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".db") continue;
+
+        auto time = taken_at(entry);
+        if (!newest || time > newest_time) {
+            newest = entry.path().string();
+            newest_time = std::move(time);
+        }
+    }
+
+    return newest;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+// FORWARD DECLARATION (same trick as ledger.hpp)
+struct sqlite3;
+
+class Backup {
+    private:
+        sqlite3* db; // Borrowed from Migrator, like the Ledger
+        std::string backup_dir;
+        int pages_per_step;
+        int busy_timeout_ms;
+
+    public:
+        // 'pages' is how many pages are copied per sqlite3_backup_step call.
+        // Locks are released between batches, so other connections keep working.
+        // 'busy_timeout' is how long (ms) we wait for another connection's lock before giving up.
+        Backup(sqlite3* database, std::string directory, int pages = 256, int busy_timeout = 5000);
+
+        // CREATE: Snapshot the live DB into '<dir>/<version>_<timestamp>.db'.
+        // Returns the snapshot path, or nullopt if the copy failed.
+        std::optional<std::string> create(std::string_view version);
+
+        // RESTORE: Overwrite the live DB with a snapshot in a single transaction
+        bool restore(const std::string& snapshot_path);
+
+        // READ: Most recently taken snapshot, by the '_<timestamp>' suffix of its name
+        // (not the version: a 'down --backup' snapshot can carry a higher version than a later one)
+        [[nodiscard]] std::optional<std::string> latest() const;
+
+    private:
+        // Runs the sqlite3_backup loop from 'source' into 'dest'
+        bool copy(sqlite3* source, sqlite3* dest, int pages);
+};
@@ -3,15 +3,24 @@
 // The only place we include the heavy C-API
 #include <sqlite3.h>
 
-#include <print>
+#include "logger.hpp"
 #include <format>
+#include <utility>
+
+namespace {
+    // sqlite3_column_text returns unsigned char* (or null), so we cast and guard here
+    std::string column_string(sqlite3_stmt* stmt, int col) {
+        const unsigned char* text = sqlite3_column_text(stmt, col);
+        return text ? reinterpret_cast<const char*>(text) : "";
+    }
+}
 
 // Constructor
-Ledger::Ledger(sqlite3* db_conn) : db(std::move(db_conn)) {
+Ledger::Ledger(sqlite3* db_conn, bool read_only) : db(std::move(db_conn)) {
     if (!db) {
         // Safety check: The program usually crashes if we use a null db pointer
-        std::println(stderr, "Critical Error: Ledger initialized with null DB connection!");
-    } else {
+        logger::error("Critical Error: Ledger initialized with null DB connection!");
+    } else if (!read_only) {
         ensure_ledger_table_exists();
     }
 }
@@ -25,7 +34,7 @@ std::set<std::string> Ledger::get_applied_versions() {
     // 1. Prepare (Compile SQL)
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
     if (rc != SQLITE_OK) {
-        std::println(stderr, "Ledger Read Error: {}", sqlite3_errmsg(db));
+        logger::error("Ledger Read Error: {}", sqlite3_errmsg(db));
         return {}; // Return empty set on failure
     }
 
@@ -44,26 +53,102 @@ std::set<std::string> Ledger::get_applied_versions() {
     return versions;
 }
 
+// READ: Slowest Migrations
+std::vector<AppliedMigration> Ledger::get_slowest_migrations(int limit) {
+    std::vector<AppliedMigration> migrations;
+    const char* sql = R"(
+        SELECT version, applied_at, engine, duration_ms, rows_changed, size_before, size_after
+        FROM tama_schema_history
+        ORDER BY duration_ms DESC, version DESC
+        LIMIT ?;
+    )";
+    sqlite3_stmt* stmt = nullptr;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        logger::error("Ledger Read Error: {}", sqlite3_errmsg(db));
+        return {};
+    }
+
+    sqlite3_bind_int(stmt, 1, limit);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        AppliedMigration m;
+        m.version = column_string(stmt, 0);
+        m.applied_at = column_string(stmt, 1);
+        m.engine = column_string(stmt, 2);
+        m.stats.duration_ms = sqlite3_column_int64(stmt, 3);
+        m.stats.rows_changed = sqlite3_column_int64(stmt, 4);
+        m.stats.size_before = sqlite3_column_int64(stmt, 5);
+        m.stats.size_after = sqlite3_column_int64(stmt, 6);
+        migrations.push_back(std::move(m));
+    }
+
+    sqlite3_finalize(stmt);
+    return migrations;
+}
+
+// READ: Run History Summary
+std::vector<RunSummary> Ledger::get_run_summary() {
+    std::vector<RunSummary> summary;
+    const char* sql = R"(
+        SELECT environment, version, COUNT(*), AVG(duration_ms), MAX(rows_changed)
+        FROM tama_run_history
+        WHERE direction = 'up' AND success = 1
+        GROUP BY environment, version
+        ORDER BY version, environment;
+    )";
+    sqlite3_stmt* stmt = nullptr;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        logger::error("Ledger Read Error: {}", sqlite3_errmsg(db));
+        return {};
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        RunSummary row;
+        row.environment = column_string(stmt, 0);
+        row.version = column_string(stmt, 1);
+        row.runs = sqlite3_column_int64(stmt, 2);
+        row.avg_duration_ms = sqlite3_column_double(stmt, 3);
+        row.max_rows_changed = sqlite3_column_int64(stmt, 4);
+        summary.push_back(std::move(row));
+    }
+
+    sqlite3_finalize(stmt);
+    return summary;
+}
+
 // UPDATE: Mark Version as Applied
-void Ledger::mark_version_as_applied(std::string_view version) {
+void Ledger::mark_version_as_applied(std::string_view version, const MigrationStats& stats,
+                                     std::string_view engine) {
     // We use ? placeholders to be safe, even internally
-    const char* sql = "INSERT INTO tama_schema_history (version, applied_at) VALUES (?, datetime('now'))";
+    const char* sql = R"(
+        INSERT INTO tama_schema_history
+            (version, applied_at, engine, duration_ms, rows_changed, size_before, size_after)
+        VALUES (?, datetime('now'), ?, ?, ?, ?, ?)
+    )";
     sqlite3_stmt* stmt = nullptr;
 
     // 1. Prepare
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::println(stderr, "Ledger Insert Error: {}", sqlite3_errmsg(db));
+        logger::error("Ledger Insert Error: {}", sqlite3_errmsg(db));
         return;
     }
 
     // 2. Bind Parameters (Replace '?' with the version string)
     // Index 1 is the first '?'
     // SQLITE_STATIC tells SQLite: "I promise this string exists until you are done using it"
-    sqlite3_bind_text(stmt, 1, version.data(), -1, SQLITE_STATIC);
+    // string_views are not null-terminated, so we pass their sizes explicitly
+    sqlite3_bind_text(stmt, 1, version.data(), static_cast<int>(version.size()), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, engine.data(), static_cast<int>(engine.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, stats.duration_ms);
+    sqlite3_bind_int64(stmt, 4, stats.rows_changed);
+    sqlite3_bind_int64(stmt, 5, stats.size_before);
+    sqlite3_bind_int64(stmt, 6, stats.size_after);
 
     // 3. Step (Run the Insert)
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        std::println(stderr, "Failed to record version {}: {}", version, sqlite3_errmsg(db));
+        logger::error("Failed to record version {}: {}", version, sqlite3_errmsg(db));
     }
 
     // 4. Finalize
@@ -78,7 +163,27 @@ void Ledger::ensure_ledger_table_exists() {
     const char* sql = R"(
         CREATE TABLE IF NOT EXISTS tama_schema_history (
             version TEXT PRIMARY KEY,
-            applied_at TEXT
+            applied_at TEXT,
+            engine TEXT,
+            duration_ms INTEGER DEFAULT 0,
+            rows_changed INTEGER DEFAULT 0,
+            size_before INTEGER DEFAULT 0,
+            size_after INTEGER DEFAULT 0
+        );
+
+        CREATE TABLE IF NOT EXISTS tama_run_history (
+            id INTEGER PRIMARY KEY,
+            version TEXT NOT NULL,
+            direction TEXT NOT NULL,
+            environment TEXT NOT NULL,
+            engine TEXT,
+            started_at TEXT,
+            duration_ms INTEGER,
+            rows_changed INTEGER,
+            size_before INTEGER,
+            size_after INTEGER,
+            commit_ms INTEGER DEFAULT 0,
+            success INTEGER NOT NULL
         );
     )";
 
@@ -87,8 +192,51 @@ void Ledger::ensure_ledger_table_exists() {
     int rc = sqlite3_exec(db, sql, nullptr, nullptr, &errMsg);
     
     if (rc != SQLITE_OK) {
-        std::println(stderr, "Ledger Init Failed: {}", errMsg ? errMsg : "Unknown error");
+        logger::error("Ledger Init Failed: {}", errMsg ? errMsg : "Unknown error");
         sqlite3_free(errMsg); // We must manually free the error message memory
+        return;
+    }
+
+    constexpr std::pair<std::string_view, std::string_view> history_columns[] = {
+        {"engine", "TEXT"},
+        {"duration_ms", "INTEGER DEFAULT 0"},
+        {"rows_changed", "INTEGER DEFAULT 0"},
+        {"size_before", "INTEGER DEFAULT 0"},
+        {"size_after", "INTEGER DEFAULT 0"},
+    };
+    constexpr std::pair<std::string_view, std::string_view> run_columns[] = {
+        {"commit_ms", "INTEGER DEFAULT 0"},
+    };
+
+    add_missing_columns("tama_schema_history", history_columns);
+    add_missing_columns("tama_run_history", run_columns);
+}
+
+// ALTER: Upgrade tables created by an older version of Tama
+void Ledger::add_missing_columns(std::string_view table,
+                                 std::span<const std::pair<std::string_view, std::string_view>> columns) {
+    std::set<std::string> existing;
+    sqlite3_stmt* stmt = nullptr;
+
+    std::string info_sql = std::format("PRAGMA table_info({});", table);
+    if (sqlite3_prepare_v2(db, info_sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        logger::error("Ledger Read Error: {}", sqlite3_errmsg(db));
+        return;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        existing.insert(column_string(stmt, 1)); // Column 1 is the column name
+    }
+    sqlite3_finalize(stmt);
+
+    for (const auto& [name, type] : columns) {
+        if (existing.contains(std::string(name))) continue;
+
+        std::string sql = std::format("ALTER TABLE {} ADD COLUMN {} {};", table, name, type);
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            logger::error("Ledger Upgrade Failed: {}", errMsg ? errMsg : "Unknown error");
+            sqlite3_free(errMsg);
+        }
     }
 }
 
@@ -100,24 +248,131 @@ void Ledger::remove_version(std::string_view version) {
 
     // 1. Prepare
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::println(stderr, "Ledger Delete Error: {}", sqlite3_errmsg(db));
+        logger::error("Ledger Delete Error: {}", sqlite3_errmsg(db));
         return;
     }
 
     // 2. Bind the version string to the '?'
     // SQLITE_STATIC means "I promise the string 'version' won't vanish before you run"
-    sqlite3_bind_text(stmt, 1, version.data(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 1, version.data(), static_cast<int>(version.size()), SQLITE_STATIC);
 
     // 3. Step (Run the Delete)
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-         std::println(stderr, "Failed to remove version {}: {}", version, sqlite3_errmsg(db));
+         logger::error("Failed to remove version {}: {}", version, sqlite3_errmsg(db));
     } else {
         // Optional: Check if a row was actually deleted
         if (sqlite3_changes(db) == 0) {
-            std::println(stderr, "Warning: Version {} was not found in history.", version);
+            logger::warn("Warning: Version {} was not found in history.", version);
         }
     }
 
     // 4. Finalize
     sqlite3_finalize(stmt);
-}
\ No newline at end of file
+}
+
+// INSERT: Record Run
+void Ledger::record_run(const RunRecord& run) {
+    insert_run(run, false);
+}
+
+// Helper: Insert one run. Only the restore path skips ids that already exist;
+// a normal insert that fails a constraint is reported, not silently dropped.
+void Ledger::insert_run(const RunRecord& run, bool skip_existing) {
+    std::string sql = std::format(R"(
+        INSERT {}INTO tama_run_history
+            (id, version, direction, environment, engine, started_at,
+             duration_ms, rows_changed, size_before, size_after, commit_ms, success)
+        VALUES (?, ?, ?, ?, ?, COALESCE(?, datetime('now')), ?, ?, ?, ?, ?, ?)
+    )", skip_existing ? "OR IGNORE " : "");
+    sqlite3_stmt* stmt = nullptr;
+
+    // 1. Prepare
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        logger::error("Ledger Insert Error: {}", sqlite3_errmsg(db));
+        return;
+    }
+
+    // 2. Bind Parameters (a NULL id / started_at lets SQLite fill them in)
+    if (run.id > 0) {
+        sqlite3_bind_int64(stmt, 1, run.id);
+    }
+    sqlite3_bind_text(stmt, 2, run.version.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, run.direction.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, run.environment.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, run.engine.c_str(), -1, SQLITE_STATIC);
+    if (!run.started_at.empty()) {
+        sqlite3_bind_text(stmt, 6, run.started_at.c_str(), -1, SQLITE_STATIC);
+    }
+    sqlite3_bind_int64(stmt, 7, run.stats.duration_ms);
+    sqlite3_bind_int64(stmt, 8, run.stats.rows_changed);
+    sqlite3_bind_int64(stmt, 9, run.stats.size_before);
+    sqlite3_bind_int64(stmt, 10, run.stats.size_after);
+    sqlite3_bind_int64(stmt, 11, run.commit_ms);
+    sqlite3_bind_int(stmt, 12, run.success ? 1 : 0);
+
+    // 3. Step (Run the Insert)
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        logger::error("Failed to record run of {}: {}", run.version, sqlite3_errmsg(db));
+    }
+
+    // 4. Finalize
+    sqlite3_finalize(stmt);
+}
+
+// READ: Full Run History
+std::vector<RunRecord> Ledger::get_run_history() {
+    std::vector<RunRecord> runs;
+    const char* sql = R"(
+        SELECT id, started_at, version, direction, environment, engine,
+               duration_ms, rows_changed, size_before, size_after, commit_ms, success
+        FROM tama_run_history
+        ORDER BY id;
+    )";
+    sqlite3_stmt* stmt = nullptr;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        logger::error("Ledger Read Error: {}", sqlite3_errmsg(db));
+        return {};
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        RunRecord run;
+        run.id = sqlite3_column_int64(stmt, 0);
+        run.started_at = column_string(stmt, 1);
+        run.version = column_string(stmt, 2);
+        run.direction = column_string(stmt, 3);
+        run.environment = column_string(stmt, 4);
+        run.engine = column_string(stmt, 5);
+        run.stats.duration_ms = sqlite3_column_int64(stmt, 6);
+        run.stats.rows_changed = sqlite3_column_int64(stmt, 7);
+        run.stats.size_before = sqlite3_column_int64(stmt, 8);
+        run.stats.size_after = sqlite3_column_int64(stmt, 9);
+        run.commit_ms = sqlite3_column_int64(stmt, 10);
+        run.success = sqlite3_column_int(stmt, 11) != 0;
+        runs.push_back(std::move(run));
+    }
+
+    sqlite3_finalize(stmt);
+    return runs;
+}
+
+// INSERT: Record Runs
+void Ledger::record_runs(const std::vector<RunRecord>& runs) {
+    insert_runs(runs, false);
+}
+
+// INSERT: Re-append Runs
+void Ledger::reinsert_runs(const std::vector<RunRecord>& runs) {
+    insert_runs(runs, true);
+}
+
+// Helper: One transaction instead of one fsync per row
+void Ledger::insert_runs(const std::vector<RunRecord>& runs, bool skip_existing) {
+    if (runs.empty()) return;
+
+    sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr);
+    for (const auto& run : runs) {
+        insert_run(run, skip_existing);
+    }
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+}
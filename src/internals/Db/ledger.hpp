@@ -1,32 +1,107 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <set>
+#include <span>
+#include <utility>
+#include <vector>
 
 // FORWARD DECLARATION
 // We tell the compiler "A struct named sqlite3 exists, trust me."
 // This lets us use 'sqlite3*' pointers without including the heavy library here.
 struct sqlite3;
 
+// What one migration cost when it ran.
+// duration_ms covers the migration's SQL only (no ledger update, no COMMIT); the
+// same number goes into both tama_schema_history and tama_run_history.
+struct MigrationStats {
+    std::int64_t duration_ms = 0;
+    std::int64_t rows_changed = 0;
+    std::int64_t size_before = 0; // Database size in bytes
+    std::int64_t size_after = 0;
+};
+
+// One row of tama_schema_history
+struct AppliedMigration {
+    std::string version;
+    std::string applied_at;
+    std::string engine;
+    MigrationStats stats;
+};
+
+// One row of tama_run_history (every up/down attempt, successful or not)
+struct RunRecord {
+    std::int64_t id = 0;     // 0 lets SQLite assign one
+    std::string started_at;  // Empty means "now"
+    std::string version;
+    std::string direction;   // "up" or "down"
+    std::string environment; // TAMA_ENV, e.g. "staging" or "production"
+    std::string engine;
+    MigrationStats stats;
+    std::int64_t commit_ms = 0; // COMMIT (fsync) time, reported separately from duration_ms
+    bool success = true;
+};
+
+// Aggregated run history for one (environment, version) pair
+struct RunSummary {
+    std::string environment;
+    std::string version;
+    std::int64_t runs = 0;
+    double avg_duration_ms = 0;
+    std::int64_t max_rows_changed = 0;
+};
+
 class Ledger {
     private:
         sqlite3* db; // We hold a reference, but we do NOT own/close it (Migrator does).
 
     public:
-        // Constructor takes an already open connection
-        Ledger(sqlite3* database);
+        // Constructor takes an already open connection.
+        // A read-only ledger never creates tables (used to read another environment's DB).
+        Ledger(sqlite3* database, bool read_only = false);
 
         // READ: returns a set of all version IDs found in the Db
         [[nodiscard]] std::set<std::string> get_applied_versions();
 
+        // READ: applied migrations, slowest first
+        [[nodiscard]] std::vector<AppliedMigration> get_slowest_migrations(int limit);
+
+        // READ: successful 'up' runs grouped by environment and version
+        [[nodiscard]] std::vector<RunSummary> get_run_summary();
+
         // UPDATE: Inserts a new migration record
-        void mark_version_as_applied(std::string_view version);
+        void mark_version_as_applied(std::string_view version, const MigrationStats& stats = {},
+                                     std::string_view engine = "");
 
         // DELETE: Removes a version record (Used during rollback/down)
         void remove_version(std::string_view version);
 
+        // INSERT: Appends to the run history (kept even when the schema history row is removed)
+        void record_run(const RunRecord& run);
+
+        // INSERT: Appends several runs in one transaction (one fsync instead of one per row)
+        void record_runs(const std::vector<RunRecord>& runs);
+
+        // READ: the full run history, oldest first
+        [[nodiscard]] std::vector<RunRecord> get_run_history();
+
+        // INSERT: Puts runs back after a restore. Rows whose id already exists are
+        // skipped, so only runs recorded after the snapshot was taken are added.
+        void reinsert_runs(const std::vector<RunRecord>& runs);
+
     private:
+        // INSERT: Shared by record_run and reinsert_runs ('skip_existing' = OR IGNORE)
+        void insert_run(const RunRecord& run, bool skip_existing);
+
+        // INSERT: Batch version of insert_run, inside a single transaction
+        void insert_runs(const std::vector<RunRecord>& runs, bool skip_existing);
+
         // CREATE: Internal helper to make sure the table exists on startup
         void ensure_ledger_table_exists();
-};
\ No newline at end of file
+
+        // Ledgers created by older versions of Tama lack some columns
+        void add_missing_columns(std::string_view table,
+                                 std::span<const std::pair<std::string_view, std::string_view>> columns);
+};
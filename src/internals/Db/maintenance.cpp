@@ -0,0 +1,141 @@
+#include "maintenance.hpp"
+
+#include <sqlite3.h>
+
+#include "logger.hpp"
+#include <format>
+#include <utility>
+
+namespace {
+    // Double-quote an identifier for use in SQL ("a""b" for embedded quotes)
+    std::string quote_identifier(const std::string& name) {
+        std::string quoted = "\"";
+        for (char c : name) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        quoted += '"';
+        return quoted;
+    }
+}
+
+Maintenance::Maintenance(sqlite3* database, MaintenanceOptions opts)
+    : db(database), options(std::move(opts)) {}
+
+// Helper: Read an integer PRAGMA
+std::int64_t Maintenance::pragma_int(const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    std::int64_t value = 0;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        logger::error("Maintenance Read Error: {}", sqlite3_errmsg(db));
+        return 0;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// Helper: Execute
+// Runs one statement to SQLITE_DONE, discarding the rows PRAGMAs return, and
+// reports failures like pragma_int does.
+bool Maintenance::exec(const std::string& sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        logger::error("Maintenance Error: {}", sqlite3_errmsg(db));
+        return false;
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {}
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_DONE) {
+        logger::error("Maintenance Error: {}", sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+// ANALYZE only what the migrations touched, so a small change on a huge DB stays cheap
+int Maintenance::analyze_tables(const std::set<std::string>& tables) {
+    // Identifiers are case-insensitive in SQLite, so 'Users' in a migration matches table 'users'
+    const char* sql = "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ? COLLATE NOCASE";
+    sqlite3_stmt* exists = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &exists, nullptr) != SQLITE_OK) {
+        logger::error("Maintenance Read Error: {}", sqlite3_errmsg(db));
+        return 0;
+    }
+
+    int analyzed = 0;
+    for (const auto& table : tables) {
+        // Tables created and dropped within the same run are gone by now
+        sqlite3_reset(exists);
+        sqlite3_bind_text(exists, 1, table.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(exists) != SQLITE_ROW) continue;
+
+        if (exec("ANALYZE " + quote_identifier(table) + ";")) {
+            logger::debug("Analyzed {}", table);
+            analyzed++;
+        }
+    }
+
+    sqlite3_finalize(exists);
+    return analyzed;
+}
+
+MaintenanceReport Maintenance::run(const std::set<std::string>& touched_tables) {
+    MaintenanceReport report;
+    if (!options.enabled) return report;
+
+    std::int64_t page_size = pragma_int("PRAGMA page_size;");
+    report.size_before = pragma_int("PRAGMA page_count;") * page_size;
+    report.free_pages_before = pragma_int("PRAGMA freelist_count;");
+
+    // 1. Refresh planner statistics for the tables we changed.
+    // analysis_limit makes ANALYZE (and optimize) sample each index instead of scanning
+    // it fully, so the cost stays bounded on large tables.
+    if ((options.analyze || options.optimize) && options.analysis_limit > 0) {
+        exec(std::format("PRAGMA analysis_limit = {};", options.analysis_limit));
+    }
+    if (options.analyze && !touched_tables.empty()) {
+        report.tables_analyzed = analyze_tables(touched_tables);
+    }
+
+    // 2. Let SQLite decide what else is worth re-analyzing
+    if (options.optimize) {
+        exec("PRAGMA optimize;");
+    }
+
+    // 3. Hand free pages back to the filesystem, a bounded number at a time.
+    // This only works with auto_vacuum=INCREMENTAL (2); switching a DB to it needs one full VACUUM.
+    if (options.vacuum_pages > 0 && report.free_pages_before > 0) {
+        if (pragma_int("PRAGMA auto_vacuum;") == 2) {
+            exec(std::format("PRAGMA incremental_vacuum({});", options.vacuum_pages));
+        } else {
+            logger::info("Note: {} free pages left in the file. Set 'PRAGMA auto_vacuum = INCREMENTAL' "
+                         "and VACUUM once to let Tama reclaim them.", report.free_pages_before);
+        }
+    }
+
+    // 4. Fold the WAL back into the main file and truncate it.
+    // log_frames stays -1 when the DB is not in WAL mode.
+    if (options.checkpoint) {
+        int log_frames = -1;
+        int checkpointed_frames = -1;
+        int rc = sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_TRUNCATE, &log_frames, &checkpointed_frames);
+        if (rc == SQLITE_OK) {
+            report.checkpointed = log_frames >= 0;
+        } else if (rc == SQLITE_BUSY) {
+            logger::warn("Warning: WAL checkpoint skipped, the database is busy.");
+        } else {
+            logger::error("Maintenance Error: {}", sqlite3_errmsg(db));
+        }
+    }
+
+    report.size_after = pragma_int("PRAGMA page_count;") * page_size;
+    report.free_pages_after = pragma_int("PRAGMA freelist_count;");
+    return report;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+// FORWARD DECLARATION (same trick as ledger.hpp)
+struct sqlite3;
+
+// Which post-migration steps to run. Loaded from TAMA_MAINTENANCE_* in .env.
+struct MaintenanceOptions {
+    bool enabled = true;
+    bool analyze = true;     // ANALYZE the tables the run touched
+    bool optimize = true;    // PRAGMA optimize
+    int vacuum_pages = 2048; // PRAGMA incremental_vacuum budget, 0 skips it
+    int analysis_limit = 1000; // PRAGMA analysis_limit: rows sampled per index by ANALYZE, 0 = no limit
+    bool checkpoint = true;  // PRAGMA wal_checkpoint(TRUNCATE), WAL databases only
+};
+
+struct MaintenanceReport {
+    std::int64_t size_before = 0; // Database size in bytes
+    std::int64_t size_after = 0;
+    std::int64_t free_pages_before = 0;
+    std::int64_t free_pages_after = 0;
+    int tables_analyzed = 0;
+    bool checkpointed = false;
+};
+
+class Maintenance {
+    private:
+        sqlite3* db; // Borrowed from Migrator, like the Ledger
+        MaintenanceOptions options;
+
+    public:
+        Maintenance(sqlite3* database, MaintenanceOptions opts);
+
+        // Runs the enabled steps outside any transaction and reports what changed
+        MaintenanceReport run(const std::set<std::string>& touched_tables);
+
+    private:
+        // Helper to read a single integer PRAGMA (page_count, freelist_count, ...)
+        std::int64_t pragma_int(const char* sql);
+
+        // Helper to run a statement and drain its rows (PRAGMAs return result rows)
+        bool exec(const std::string& sql);
+
+        int analyze_tables(const std::set<std::string>& tables);
+};
@@ -0,0 +1,210 @@
+#include "logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace logger {
+    namespace {
+        std::atomic<Level> current_level{Level::Info};
+        std::atomic<Format> current_format{Format::Text};
+
+        std::string_view level_name(Level level) {
+            switch (level) {
+                case Level::Debug: return "debug";
+                case Level::Info:  return "info";
+                case Level::Warn:  return "warn";
+                case Level::Error: return "error";
+                case Level::Off:   return "off";
+            }
+            return "info";
+        }
+
+        // Escape a message so it can sit inside a JSON string literal
+        void append_json_escaped(std::string& out, std::string_view text) {
+            for (char c : text) {
+                switch (c) {
+                    case '"':  out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+        }
+
+        std::string render(Level level, std::string_view message) {
+            std::string line;
+            if (current_format.load(std::memory_order_relaxed) == Format::Json) {
+                auto now = std::chrono::floor<std::chrono::milliseconds>(std::chrono::system_clock::now());
+                line = std::format(R"({{"ts":"{:%FT%TZ}","level":"{}","msg":")", now, level_name(level));
+                append_json_escaped(line, message);
+                line += "\"}\n";
+            } else {
+                if (level == Level::Debug) line += "DEBUG: ";
+                line += message;
+                line += '\n';
+            }
+            return line;
+        }
+
+        /*
+           The sink keeps two in-memory buffers (stdout and stderr) and only touches
+           the terminal when they fill up, on flush() or at shutdown. Warnings and
+           errors force a flush so diagnostics are never held back.
+
+           In async mode a background thread does the writing, so the migration
+           loop only pays for a string append under a mutex.
+        */
+        class Sink {
+        public:
+            ~Sink() { stop(); }
+
+            void configure(const Options& options) {
+                stop();
+                {
+                    std::lock_guard lock(mtx);
+                    capacity = options.buffer_bytes;
+                    async = options.async;
+                }
+                if (options.async) {
+                    worker = std::thread([this] { run(); });
+                }
+            }
+
+            void write(Level level, std::string line) {
+                bool urgent = false;
+                {
+                    std::lock_guard lock(mtx);
+                    (level >= Level::Warn ? err : out).append(line);
+                    urgent = level >= Level::Warn || out.size() + err.size() >= capacity;
+                    if (urgent && async) wake = true;
+                }
+                if (!urgent) return;
+
+                if (async) {
+                    cv.notify_one();
+                } else {
+                    drain();
+                }
+            }
+
+            void flush() { drain(); }
+
+            void stop() {
+                if (worker.joinable()) {
+                    {
+                        std::lock_guard lock(mtx);
+                        stopping = true;
+                    }
+                    cv.notify_one();
+                    worker.join();
+
+                    std::lock_guard lock(mtx);
+                    stopping = false;
+                    async = false;
+                }
+                drain();
+            }
+
+        private:
+            std::mutex mtx;     // Guards the buffers and flags below
+            std::mutex io_mtx;  // Serialises writers so batches reach the terminal in order
+            std::condition_variable cv;
+            std::string out;
+            std::string err;
+            std::size_t capacity = 64 * 1024;
+            bool async = false;
+            bool wake = false;
+            bool stopping = false;
+            std::thread worker;
+
+            // Swap the buffers out under the lock, then write them without holding it
+            void drain() {
+                std::lock_guard io_lock(io_mtx);
+                std::string ready_out;
+                std::string ready_err;
+                {
+                    std::lock_guard lock(mtx);
+                    ready_out.swap(out);
+                    ready_err.swap(err);
+                }
+
+                if (!ready_out.empty()) {
+                    std::fwrite(ready_out.data(), 1, ready_out.size(), stdout);
+                    std::fflush(stdout);
+                }
+                if (!ready_err.empty()) {
+                    std::fwrite(ready_err.data(), 1, ready_err.size(), stderr);
+                    std::fflush(stderr);
+                }
+            }
+
+            void run() {
+                using namespace std::chrono_literals;
+                while (true) {
+                    {
+                        std::unique_lock lock(mtx);
+                        cv.wait_for(lock, 100ms, [this] { return wake || stopping; });
+                        wake = false;
+                        if (stopping && out.empty() && err.empty()) break;
+                    }
+                    drain();
+                }
+            }
+        };
+
+        Sink& sink() {
+            static Sink instance;
+            return instance;
+        }
+    } // namespace
+
+    void init(const Options& options) {
+        current_level.store(options.level, std::memory_order_relaxed);
+        current_format.store(options.format, std::memory_order_relaxed);
+        sink().configure(options);
+    }
+
+    void flush() {
+        sink().flush();
+    }
+
+    void shutdown() {
+        sink().stop();
+    }
+
+    bool enabled(Level level) {
+        return level >= current_level.load(std::memory_order_relaxed);
+    }
+
+    void write(Level level, std::string_view message) {
+        sink().write(level, render(level, message));
+    }
+
+    std::optional<Level> parse_level(std::string_view name) {
+        if (name == "debug") return Level::Debug;
+        if (name == "info") return Level::Info;
+        if (name == "warn" || name == "warning") return Level::Warn;
+        if (name == "error" || name == "quiet") return Level::Error;
+        if (name == "off") return Level::Off;
+        return std::nullopt;
+    }
+
+    std::optional<Format> parse_format(std::string_view name) {
+        if (name == "text") return Format::Text;
+        if (name == "json") return Format::Json;
+        return std::nullopt;
+    }
+} // namespace logger
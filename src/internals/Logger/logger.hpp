@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace logger {
+    // Ordered by severity: a message is written when its level >= the configured one.
+    // Off is only meaningful as a threshold and silences everything ('--quiet' is Error).
+    enum class Level { Debug, Info, Warn, Error, Off };
+
+    // Text is the human-friendly console output, Json emits one object per line
+    enum class Format { Text, Json };
+
+    struct Options {
+        Level level = Level::Info;
+        Format format = Format::Text;
+        bool async = false;                // Hand buffered lines to a background writer thread
+        std::size_t buffer_bytes = 64 * 1024; // Flush threshold for the in-memory buffer
+    };
+
+    // Configure the process-wide sink. Safe to call again; pending lines are flushed first.
+    void init(const Options& options);
+
+    // Push everything buffered so far to stdout/stderr. Call it before a long step,
+    // so the line announcing it is on screen (and survives a crash) while it runs.
+    void flush();
+
+    // Flush and stop the background writer (if any). Also runs automatically at exit.
+    void shutdown();
+
+    [[nodiscard]] bool enabled(Level level);
+
+    // Write an already formatted message. Prefer the typed helpers below.
+    void write(Level level, std::string_view message);
+
+    // Parse the values accepted by TAMA_LOG_LEVEL / TAMA_LOG_FORMAT
+    std::optional<Level> parse_level(std::string_view name);
+    std::optional<Format> parse_format(std::string_view name);
+
+    // The level check happens before formatting, so disabled debug lines cost nothing
+    template <typename... Args>
+    void debug(std::format_string<Args...> fmt, Args&&... args) {
+        if (enabled(Level::Debug)) write(Level::Debug, std::format(fmt, std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    void info(std::format_string<Args...> fmt, Args&&... args) {
+        if (enabled(Level::Info)) write(Level::Info, std::format(fmt, std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    void warn(std::format_string<Args...> fmt, Args&&... args) {
+        if (enabled(Level::Warn)) write(Level::Warn, std::format(fmt, std::forward<Args>(args)...));
+    }
+
+    // Output the user explicitly asked for (help, usage, reports). Shown at every
+    // level except Off, so '--quiet' does not hide it.
+    template <typename... Args>
+    void print(std::format_string<Args...> fmt, Args&&... args) {
+        if (enabled(Level::Error)) write(Level::Info, std::format(fmt, std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    void error(std::format_string<Args...> fmt, Args&&... args) {
+        if (enabled(Level::Error)) write(Level::Error, std::format(fmt, std::forward<Args>(args)...));
+    }
+} // namespace logger
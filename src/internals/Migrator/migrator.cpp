@@ -1,24 +1,47 @@
 #include "migrator.hpp"
 #include "parser.hpp"
+#include "logger.hpp"
+#include "backup.hpp"
+#include "maintenance.hpp"
 #include <sqlite3.h>
-#include <print>
-#include <sstream>
+#include <format>
+#include <vector>
 #include <utility>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <algorithm>
 #include <ranges>
+#include <map>
+#include <cstdint>
 
 namespace fs = std::filesystem;
 
-Migrator::Migrator(std::string migrationPath, std::string dbConnStr, std::string dbEngine)
+namespace {
+    std::int64_t elapsed_ms(std::chrono::steady_clock::time_point started) {
+        auto elapsed = std::chrono::steady_clock::now() - started;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    }
+
+    std::string format_duration(double ms) {
+        if (ms < 1000) return std::format("{:.0f} ms", ms);
+        if (ms < 60'000) return std::format("{:.1f} s", ms / 1000);
+        return std::format("{:.1f} min", ms / 60'000);
+    }
+
+    std::string format_size_delta(std::int64_t bytes) {
+        return std::format("{:+.1f} KiB", static_cast<double>(bytes) / 1024);
+    }
+}
+
+Migrator::Migrator(std::string migrationPath, std::string dbConnStr, std::string dbEngine, std::string env)
     : migration_path(std::move(migrationPath)),
       db_conn_str(std::move(dbConnStr)),
-      db_engine(std::move(dbEngine))
+      db_engine(std::move(dbEngine)),
+      environment(std::move(env))
 {
     // 1. Open SQLite Database
-    std::println("DEBUG: Attempting to create DB at: [{}]", db_conn_str);
+    logger::debug("Attempting to create DB at: [{}]", db_conn_str);
     std::string db_file = db_conn_str; 
     
     if (sqlite3_open(db_file.c_str(), &db) != SQLITE_OK) {
@@ -34,7 +57,7 @@ Migrator::Migrator(std::string migrationPath, std::string dbConnStr, std::string
 }
 
 Migrator::~Migrator() {
-    std::println("Migrator destructor called");
+    logger::debug("Migrator destructor called");
     if (db) {
         sqlite3_close(db);
         db = nullptr;
@@ -42,7 +65,7 @@ Migrator::~Migrator() {
 }
 
 void Migrator::scan_and_print_migrations() {
-    std::println("Scanning directory: {}", migration_path);
+    logger::info("Scanning directory: {}", migration_path);
 
     // 1. Check if directory exists
     if (!fs::exists(migration_path)) {
@@ -64,11 +87,11 @@ void Migrator::scan_and_print_migrations() {
 
     // 4. Print
     if (files.empty()) {
-        std::println("No migration files found.");
+        logger::info("No migration files found.");
     } else {
-        std::println("Found {} migrations:", files.size());
+        logger::info("Found {} migrations:", files.size());
         for (const auto& f : files) {
-            std::println(" - {}", f);
+            logger::info(" - {}", f);
         }
     }
 }
@@ -87,9 +110,212 @@ void Migrator::generate_migration(std::string_view name) {
     if (outfile.is_open()) {
         outfile << migration_file_template;
         outfile.close();
-        std::println("Created migration: {}", filename);
+        logger::info("Created migration: {}", filename);
     } else {
-        std::println(stderr, "Error: Could not create file at {}", filename);
+        logger::error("Error: Could not create file at {}", filename);
+    }
+}
+
+void Migrator::enable_backups(std::string directory) {
+    backup_dir = std::move(directory);
+}
+
+// Helper: Backup
+bool Migrator::take_backup(const std::set<std::string>& applied_versions) {
+    // Versions are timestamps, so the last one in the (sorted) set is the newest
+    std::string version = applied_versions.empty() ? "0" : *applied_versions.rbegin();
+
+    logger::info("Backing up database (version {})...", version);
+    logger::flush();
+    Backup backup(db, *backup_dir);
+    auto snapshot = backup.create(version);
+    if (!snapshot) {
+        logger::error("Backup failed! Not migrating.");
+        return false;
+    }
+
+    logger::info("Backup written: {}", *snapshot);
+    return true;
+}
+
+bool Migrator::restore(std::string directory, std::string_view snapshot_path) {
+    Backup backup(db, std::move(directory));
+
+    std::string snapshot(snapshot_path);
+    if (snapshot.empty()) {
+        auto latest = backup.latest();
+        if (!latest) {
+            logger::error("Error: No snapshots found to restore.");
+            return false;
+        }
+        snapshot = *latest;
+    }
+
+    // The snapshot carries an older copy of tama_run_history. Keep the current one
+    // (including the failed run that probably led to this restore) and put it back after.
+    auto run_history = ledger->get_run_history();
+
+    logger::info("Restoring: {}", snapshot);
+    logger::flush();
+    if (!backup.restore(snapshot)) {
+        logger::error("Restore failed! Database left unchanged.");
+        return false;
+    }
+
+    // Re-attach the Ledger so tables missing from an older snapshot are recreated
+    ledger.emplace(db);
+    ledger->reinsert_runs(run_history);
+
+    logger::info("Restored database from {}", snapshot);
+    return true;
+}
+
+void Migrator::set_maintenance(MaintenanceOptions options) {
+    maintenance_options = options;
+}
+
+// Helper: Maintenance
+void Migrator::run_maintenance() {
+    if (!maintenance_options.enabled) return;
+
+    logger::info("Running maintenance...");
+    logger::flush();
+    Maintenance maintenance(db, maintenance_options);
+    MaintenanceReport report = maintenance.run(touched_tables);
+
+    logger::info("Maintenance: analyzed {} table(s), free pages {} -> {}, reclaimed {:.1f} KiB{}",
+                 report.tables_analyzed, report.free_pages_before, report.free_pages_after,
+                 static_cast<double>(report.size_before - report.size_after) / 1024,
+                 report.checkpointed ? ", WAL checkpointed" : "");
+    touched_tables.clear();
+}
+
+// Helper: Database size in bytes (pages in use, including uncommitted ones)
+std::int64_t Migrator::database_size() {
+    const char* sql = "SELECT page_count * page_size FROM pragma_page_count(), pragma_page_size();";
+    sqlite3_stmt* stmt = nullptr;
+    std::int64_t size = 0;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        size = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return size;
+}
+
+// Helper: Append to the run history
+// Writing each successful run on its own would cost a second fsync per migration,
+// so they are queued and written by flush_runs() at the end of up/down.
+void Migrator::record_run(const std::string& version, std::string_view direction,
+                          const MigrationStats& stats, bool success, std::int64_t commit_ms) {
+    auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+    pending_runs.push_back({
+        .started_at = std::format("{:%F %T}", now), // Same UTC format as datetime('now')
+        .version = version,
+        .direction = std::string(direction),
+        .environment = environment,
+        .engine = db_engine,
+        .stats = stats,
+        .commit_ms = commit_ms,
+        .success = success,
+    });
+
+    if (!success) flush_runs();
+}
+
+void Migrator::flush_runs() {
+    ledger->record_runs(pending_runs);
+    pending_runs.clear();
+}
+
+// The STATS LOGIC
+void Migrator::stats(int limit, std::string_view compare_db) {
+    // A. Slowest applied migrations in this database
+    auto slowest = ledger->get_slowest_migrations(limit);
+    if (slowest.empty()) {
+        logger::print("No applied migrations recorded yet.");
+    } else {
+        logger::print("Slowest migrations ({}):", environment);
+        logger::print("  {:<16} {:>10} {:>12} {:>14}  {}", "VERSION", "DURATION", "ROWS", "SIZE DELTA", "APPLIED AT");
+        for (const auto& m : slowest) {
+            logger::print("  {:<16} {:>10} {:>12} {:>14}  {}", m.version,
+                         format_duration(static_cast<double>(m.stats.duration_ms)), m.stats.rows_changed,
+                         format_size_delta(m.stats.size_after - m.stats.size_before), m.applied_at);
+        }
+    }
+
+    // B. Successful runs per environment, from this DB and optionally another one
+    auto summary = ledger->get_run_summary();
+
+    if (!compare_db.empty()) {
+        std::string other_path(compare_db);
+        sqlite3* other = nullptr;
+        if (sqlite3_open_v2(other_path.c_str(), &other, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+            logger::error("Error: Could not open {}: {}", other_path,
+                          other ? sqlite3_errmsg(other) : "Memory allocation failed");
+        } else {
+            Ledger other_ledger(other, true);
+            for (auto row : other_ledger.get_run_summary()) {
+                // Keep the two databases apart if both use the same TAMA_ENV
+                if (row.environment == environment) row.environment += " (compare)";
+                summary.push_back(std::move(row));
+            }
+        }
+        sqlite3_close(other);
+    }
+
+    if (summary.empty()) {
+        logger::print("No run history recorded yet.");
+        return;
+    }
+
+    // C. Pivot: one row per version, one column per environment
+    std::vector<std::string> environments;
+    std::map<std::string, std::map<std::string, double>> by_version;
+    for (const auto& row : summary) {
+        if (std::ranges::find(environments, row.environment) == environments.end()) {
+            environments.push_back(row.environment);
+        }
+        by_version[row.version][row.environment] = row.avg_duration_ms;
+    }
+
+    std::string header = std::format("  {:<16}", "VERSION");
+    for (const auto& env : environments) header += std::format(" {:>14}", env);
+    logger::print("");
+    logger::print("Average duration by environment:");
+    logger::print("{}", header);
+
+    for (const auto& [version, durations] : by_version) {
+        std::string line = std::format("  {:<16}", version);
+        for (const auto& env : environments) {
+            auto it = durations.find(env);
+            line += std::format(" {:>14}", it == durations.end() ? "-" : format_duration(it->second));
+        }
+        logger::print("{}", line);
+    }
+
+    // D. Ratios against the current environment, over the versions both ran.
+    // This is the number to multiply a staging timing by to predict production.
+    if (std::ranges::find(environments, environment) == environments.end()) return;
+
+    for (const auto& env : environments) {
+        if (env == environment) continue;
+
+        double base_total = 0;
+        double other_total = 0;
+        int shared = 0;
+        for (const auto& [version, durations] : by_version) {
+            if (durations.contains(environment) && durations.contains(env)) {
+                base_total += durations.at(environment);
+                other_total += durations.at(env);
+                shared++;
+            }
+        }
+
+        if (shared > 0 && base_total > 0) {
+            logger::print("{} vs {}: {:.2f}x over {} shared migration(s)", env, environment,
+                         other_total / base_total, shared);
+        }
     }
 }
 
@@ -97,30 +323,72 @@ void Migrator::generate_migration(std::string_view name) {
 std::string Migrator::read_file_content(const std::string& filepath) {
     std::ifstream in(filepath, std::ios::in | std::ios::binary);
     if (!in) {
-        std::println(stderr, "Error: Could not read file {}", filepath);
+        logger::error("Error: Could not read file {}", filepath);
         return "";
     }
 
-    std::ostringstream contents;
-    contents << in.rdbuf();
-    return contents.str();
+    // Size the string up front and read straight into it: going through a
+    // stringstream would briefly hold a second copy of a large seed file.
+    in.seekg(0, std::ios::end);
+    std::string contents(static_cast<std::size_t>(in.tellg()), '\0');
+    in.seekg(0, std::ios::beg);
+    in.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+    return contents;
 }
 
 // Helper: Execute
+// 'sql' is usually a slice of a larger file (not null-terminated), so we hand SQLite
+// an explicit length and step through every statement it contains.
 bool Migrator::execute_sql(std::string_view sql) {
-    char* errMsg = nullptr;
-    int rc = sqlite3_exec(db, sql.data(), nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK) {
-        std::println(stderr, "SQL Error: {}", errMsg);
-        sqlite3_free(errMsg);
-        return false;
+    const char* tail = sql.data();
+    const char* const end = sql.data() + sql.size();
+
+    while (tail < end) {
+        sqlite3_stmt* stmt = nullptr;
+        int rc = sqlite3_prepare_v2(db, tail, static_cast<int>(end - tail), &stmt, &tail);
+        if (rc != SQLITE_OK) {
+            logger::error("SQL Error: {}", sqlite3_errmsg(db));
+            return false;
+        }
+        if (!stmt) continue; // Only whitespace or comments were left
+
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {}
+        sqlite3_finalize(stmt);
+
+        if (rc != SQLITE_DONE) {
+            logger::error("SQL Error: {}", sqlite3_errmsg(db));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Helper: Run each parsed statement of a section, reporting where a failure happened
+bool Migrator::execute_statements(std::string_view section_sql,
+                                  const std::vector<SqlStatement>& statements,
+                                  std::string_view filename) {
+    // Seed files repeat the same INSERT target thousands of times; only a change
+    // of table costs a std::string and a set lookup.
+    std::string_view last_table;
+    for (const auto& stmt : statements) {
+        std::string_view sql = section_sql.substr(stmt.offset, stmt.length);
+        if (!execute_sql(sql)) {
+            logger::error("Failed statement at {}:{}", filename, stmt.line);
+            return false;
+        }
+
+        auto table = Parser::target_table(sql);
+        if (table && *table != last_table) {
+            touched_tables.emplace(*table);
+            last_table = *table;
+        }
     }
     return true;
 }
 
 // The UP LOGIC
-void Migrator::up() {
-    std::println("Checking for pending migrations...");
+bool Migrator::up() {
+    logger::info("Checking for pending migrations...");
 
     // A. Get history from Ledger
     // Note: ledger is std::optional, so use '->'
@@ -138,6 +406,7 @@ void Migrator::up() {
 
     // C. Iterate and apply
     int count = 0;
+    bool backed_up = false;
     for (const auto& filename : files) {
         // Extract Version (assumes format: 20251218xxxxx_name.sql)
         // We take the substring before the first '_'
@@ -148,7 +417,8 @@ void Migrator::up() {
             continue;
         }
 
-        std::println("Applying: {}", filename);
+        logger::info("Applying: {}", filename);
+        logger::flush(); // Keep the running migration on screen, even if the run is killed
 
         // 1. Read & Parse
         std::string full_path = migration_path + "/" + filename;
@@ -156,52 +426,76 @@ void Migrator::up() {
         ParsedMigration parsed = Parser::parse(content);
 
         if (parsed.up_sql.empty()) {
-            std::println("Warning: No UP block found in {}", filename);
+            logger::warn("Warning: No UP block found in {}", filename);
             continue;
         }
 
-        // 2. BEGIN TRANSACTION
+        // 2. BACKUP (opt-in), once, right before the first change
+        if (backup_dir && !backed_up) {
+            if (!take_backup(applied_versions)) return false;
+            backed_up = true;
+        }
+
+        // 3. BEGIN TRANSACTION
         // This is crucial. If the script fails halfway, we want to undo it.
+        MigrationStats stats;
+        stats.size_before = database_size();
+        std::int64_t changes_before = sqlite3_total_changes64(db);
+        auto started = std::chrono::steady_clock::now();
         execute_sql("BEGIN TRANSACTION;");
 
-        // 3. Run the user's SQL
-        if (!execute_sql(parsed.up_sql)) {
-            std::println(stderr, "Migration failed! Rolling back...");
+        // 4. Run the user's SQL
+        if (!execute_statements(parsed.up_sql, parsed.up_statements, filename)) {
+            logger::error("Migration failed! Rolling back...");
             execute_sql("ROLLBACK;");
-            return; // Stop everything
+            stats.duration_ms = elapsed_ms(started);
+            record_run(version, "up", stats, false);
+            return false; // Stop everything
         }
 
-        // 4. Update Ledger
-        ledger->mark_version_as_applied(version);
+        // 5. Update Ledger (with what the SQL itself cost)
+        stats.rows_changed = sqlite3_total_changes64(db) - changes_before;
+        stats.duration_ms = elapsed_ms(started);
+        stats.size_after = database_size();
+        ledger->mark_version_as_applied(version, stats, db_engine);
 
-        // 5. COMMIT
+        // 6. COMMIT
         // If we got here, both the SQL and the Ledger update are pending.
         // This saves them both to disk at the exact same time.
+        auto commit_started = std::chrono::steady_clock::now();
         if (execute_sql("COMMIT;")) {
-            std::println("Success: {}", filename);
+            // Same duration_ms as the ledger row; COMMIT (fsync) time is kept apart
+            record_run(version, "up", stats, true, elapsed_ms(commit_started));
+
+            logger::info("Success: {} ({})", filename, format_duration(static_cast<double>(stats.duration_ms)));
             count++;
         } else {
-             std::println(stderr, "Commit failed! Rolling back...");
+             logger::error("Commit failed! Rolling back...");
              execute_sql("ROLLBACK;");
-             return;
+             record_run(version, "up", stats, false, elapsed_ms(commit_started));
+             return false;
         }
     }
 
+    flush_runs();
+
     if (count == 0) {
-        std::println("Database is up to date.");
+        logger::info("Database is up to date.");
     } else {
-        std::println("Applied {} migrations.", count);
+        logger::info("Applied {} migrations.", count);
+        run_maintenance();
     }
-    
+
+    return true;
 }
 
 // The DROP LOGIC
-void Migrator::down(int steps) {
+bool Migrator::down(int steps) {
 
     if (steps == -1) {
-        std::println("Reverting ALL migrations (Reset)...");
+        logger::info("Reverting ALL migrations (Reset)...");
     } else {
-        std::println("Reverting last {} migration(s)...", steps);
+        logger::info("Reverting last {} migration(s)...", steps);
     }
 
     // A. Get history from Ledger
@@ -220,6 +514,7 @@ void Migrator::down(int steps) {
 
     // C. Iterate and apply
     int count = 0;
+    bool backed_up = false;
     for (const auto& filename : files | std::views::reverse) {
 
         // 1. CHECK LIMIT
@@ -237,7 +532,8 @@ void Migrator::down(int steps) {
             continue;
         }
 
-        std::println("Dropping: {}", filename);
+        logger::info("Dropping: {}", filename);
+        logger::flush(); // Keep the running migration on screen, even if the run is killed
 
         // 1. Read & Parse
         std::string full_path = migration_path + "/" + filename;
@@ -245,43 +541,67 @@ void Migrator::down(int steps) {
         ParsedMigration parsed = Parser::parse(content);
 
         if (parsed.down_sql.empty()) {
-            std::println("Warning: No DOWN block found in {}", filename);
+            logger::warn("Warning: No DOWN block found in {}", filename);
             continue;
         }
 
-        std::println("Executing DOWN SQL: {}", parsed.down_sql);
+        logger::debug("Executing DOWN SQL: {}", parsed.down_sql);
+
+        // 2. BACKUP (opt-in), once, right before the first change
+        if (backup_dir && !backed_up) {
+            if (!take_backup(applied_versions)) return false;
+            backed_up = true;
+        }
 
-        // 2. BEGIN TRANSACTION
+        // 3. BEGIN TRANSACTION
         // This is crucial. If the script fails halfway, we want to undo it.
+        MigrationStats stats;
+        stats.size_before = database_size();
+        std::int64_t changes_before = sqlite3_total_changes64(db);
+        auto started = std::chrono::steady_clock::now();
         execute_sql("BEGIN TRANSACTION;");
 
-        // 3. Run the user's SQL
-        if (!execute_sql(parsed.down_sql)) {
-            std::println(stderr, "Migration Drop failed! Rolling back...");
+        // 4. Run the user's SQL
+        if (!execute_statements(parsed.down_sql, parsed.down_statements, filename)) {
+            logger::error("Migration Drop failed! Rolling back...");
             execute_sql("ROLLBACK;");
-            return; // Stop everything
+            stats.duration_ms = elapsed_ms(started);
+            record_run(version, "down", stats, false);
+            return false; // Stop everything
         }
 
-        // 4. Update Ledger
+        // 5. Update Ledger (measured first, so the ledger DELETE is not counted)
+        stats.rows_changed = sqlite3_total_changes64(db) - changes_before;
+        stats.duration_ms = elapsed_ms(started);
+        stats.size_after = database_size();
         ledger->remove_version(version);
 
-        // 5. COMMIT
+        // 6. COMMIT
         // If we got here, both the SQL and the Ledger update are pending.
         // This saves them both to disk at the exact same time.
+        auto commit_started = std::chrono::steady_clock::now();
         if (execute_sql("COMMIT;")) {
-            std::println("Success: {}", filename);
+            // Same duration_ms as the ledger row; COMMIT (fsync) time is kept apart
+            record_run(version, "down", stats, true, elapsed_ms(commit_started));
+
+            logger::info("Success: {} ({})", filename, format_duration(static_cast<double>(stats.duration_ms)));
             count++;
         } else {
-             std::println(stderr, "Commit failed! Rolling back...");
+             logger::error("Commit failed! Rolling back...");
              execute_sql("ROLLBACK;");
-             return;
+             record_run(version, "down", stats, false, elapsed_ms(commit_started));
+             return false;
         }
     }
 
+    flush_runs();
+
     if (count == 0) {
-        std::println("Database is up to date.");
+        logger::info("Database is up to date.");
     } else {
-        std::println("Dropped {} migrations.", count);
+        logger::info("Dropped {} migrations.", count);
+        run_maintenance();
     }
-    
+
+    return true;
 }
\ No newline at end of file
@@ -1,16 +1,24 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <set>
+#include <vector>
 #include "../Db/ledger.hpp"
+#include "../Db/maintenance.hpp"
+#include "../Parser/parser.hpp"
 
 // Forward declaration (avoids including <sqlite3.h> here)
 struct sqlite3;
 
 class Migrator {
 public:
-    // Constructor now establishes the DB connection
-    Migrator(std::string migrationPath, std::string dbConnStr, std::string dbEngine);
+    // Constructor now establishes the DB connection.
+    // 'env' labels the run history (TAMA_ENV), e.g. "staging" or "production".
+    Migrator(std::string migrationPath, std::string dbConnStr, std::string dbEngine,
+             std::string env = "default");
     
     // Destructor closes the DB
     ~Migrator();
@@ -21,24 +29,49 @@ public:
     // 2. Scan and print files (The new requirement)
     void scan_and_print_migrations();
 
-    // 3. Run UP migrations
-    void up();
+    // 3. Run UP migrations. Returns false if a migration failed (and was rolled back).
+    bool up();
 
     // 3. Run Down migrations
-    void down(int steps = 1);
+    bool down(int steps = 1);
 
     // 4. Run Drop all migrations
-    void reset() {down(-1); }
+    bool reset() { return down(-1); }
+
+    // 5. Snapshot the DB into 'directory' before the first migration of up/down runs
+    void enable_backups(std::string directory);
+
+    // 6. Restore a snapshot (the latest one in 'directory' if no path is given)
+    bool restore(std::string directory, std::string_view snapshot_path = {});
+
+    // 7. Configure the maintenance stage that runs after a successful up/down
+    void set_maintenance(MaintenanceOptions options);
+
+    // 8. Report the slowest migrations and compare run history across environments.
+    // 'compare_db' optionally points at another environment's database file.
+    void stats(int limit = 10, std::string_view compare_db = {});
 
 private:
     std::string migration_path;
     std::string db_conn_str;
     std::string db_engine;
+    std::string environment;
 
     // DB Resources
     sqlite3* db = nullptr; // Migrator owns this
     std::optional<Ledger> ledger;// Migrator owns the instance (which borrows the ptr)
 
+    // Set by enable_backups(); empty means no snapshot is taken
+    std::optional<std::string> backup_dir;
+
+    MaintenanceOptions maintenance_options;
+
+    // Tables written to during this run, ANALYZEd by the maintenance stage
+    std::set<std::string> touched_tables;
+
+    // Run history not written yet. Successful runs are batched (see flush_runs).
+    std::vector<RunRecord> pending_runs;
+
     const std::string migration_file_template = R"(-- +tama up
 SELECT 'up SQL query';
 
@@ -48,6 +81,28 @@ SELECT 'down SQL query';)";
     // Helper to read a file from disk into a string
     std::string read_file_content(const std::string& filename);
     
+    // Helper to snapshot the DB, tagged with the newest applied version
+    bool take_backup(const std::set<std::string>& applied_versions);
+
+    // Helper to run the maintenance stage and report what it reclaimed
+    void run_maintenance();
+
+    // Helper to measure the DB file (page_count * page_size)
+    std::int64_t database_size();
+
+    // Helper to append an up/down attempt to the run history. Successful runs are
+    // queued; a failed one is written right away, together with the queue.
+    void record_run(const std::string& version, std::string_view direction,
+                    const MigrationStats& stats, bool success, std::int64_t commit_ms = 0);
+
+    // Helper to write the queued runs in a single transaction
+    void flush_runs();
+
     // Helper to run a raw SQL string safely
     bool execute_sql(std::string_view sql);
+
+    // Helper to run the statements the Parser split out of a section
+    bool execute_statements(std::string_view section_sql,
+                            const std::vector<SqlStatement>& statements,
+                            std::string_view filename);
 };
\ No newline at end of file
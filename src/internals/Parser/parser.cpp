@@ -1,39 +1,513 @@
 #include "parser.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
 #include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
-#include <algorithm>
+
+// TAMA_PARSER_SCALAR forces the portable loop (the tests use it as the reference)
+#if defined(TAMA_PARSER_SCALAR)
+#elif defined(__AVX2__)
+    #include <immintrin.h>
+    #define TAMA_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define TAMA_SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define TAMA_SIMD_NEON 1
+#endif
+
+namespace {
+    constexpr std::size_t npos = std::string_view::npos;
+
+    // A small set of "interesting" bytes. The lexer only ever stops on these,
+    // everything in between (identifiers, keywords, whitespace) is skipped in bulk.
+    // The broadcast comparison vectors are built once here, not on every scan.
+    struct ByteSet {
+        std::array<bool, 256> table{};
+        std::size_t count = 0;
+#if defined(TAMA_SIMD_AVX2)
+        __m256i needles[8];
+#elif defined(TAMA_SIMD_SSE2)
+        __m128i needles[8];
+#elif defined(TAMA_SIMD_NEON)
+        uint8x16_t needles[8];
+#endif
+
+        explicit ByteSet(std::string_view chars) {
+            for (char c : chars) {
+                table[static_cast<unsigned char>(c)] = true;
+#if defined(TAMA_SIMD_AVX2)
+                needles[count] = _mm256_set1_epi8(c);
+#elif defined(TAMA_SIMD_SSE2)
+                needles[count] = _mm_set1_epi8(c);
+#elif defined(TAMA_SIMD_NEON)
+                needles[count] = vdupq_n_u8(static_cast<std::uint8_t>(c));
+#endif
+                count++;
+            }
+        }
+
+        [[nodiscard]] bool contains(char c) const {
+            return table[static_cast<unsigned char>(c)];
+        }
+    };
+
+    const ByteSet code_bytes{"'\"`[-/;"};
+    const ByteSet single_quote{"'"};
+    const ByteSet double_quote{"\""};
+    const ByteSet backtick{"`"};
+    const ByteSet close_bracket{"]"};
+    const ByteSet newline{"\n"};
+    const ByteSet star{"*"};
+
+    // Returns the index of the first byte in 'text' at or after 'pos' that is in 'set',
+    // or text.size() if there is none. This is the hot loop for large seed files, so
+    // it compares 16/32 bytes at a time where the target supports it.
+    std::size_t find_any(std::string_view text, std::size_t pos, const ByteSet& set) {
+        const char* p = text.data() + pos;
+        const char* const end = text.data() + text.size();
+
+#if defined(TAMA_SIMD_AVX2)
+        while (end - p >= 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i hits = _mm256_setzero_si256();
+            for (std::size_t i = 0; i < set.count; ++i) {
+                hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, set.needles[i]));
+            }
+            auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(hits));
+            if (mask != 0) return static_cast<std::size_t>(p - text.data()) + std::countr_zero(mask);
+            p += 32;
+        }
+#elif defined(TAMA_SIMD_SSE2)
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_setzero_si128();
+            for (std::size_t i = 0; i < set.count; ++i) {
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, set.needles[i]));
+            }
+            auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(hits));
+            if (mask != 0) return static_cast<std::size_t>(p - text.data()) + std::countr_zero(mask);
+            p += 16;
+        }
+#elif defined(TAMA_SIMD_NEON)
+        while (end - p >= 16) {
+            uint8x16_t chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(p));
+            uint8x16_t hits = vdupq_n_u8(0);
+            for (std::size_t i = 0; i < set.count; ++i) {
+                hits = vorrq_u8(hits, vceqq_u8(chunk, set.needles[i]));
+            }
+            if (vmaxvq_u8(hits) != 0) break; // The scalar tail below pins down the exact byte
+            p += 16;
+        }
+#endif
+
+        while (p < end && !set.contains(*p)) ++p;
+        return static_cast<std::size_t>(p - text.data());
+    }
+
+    enum class Annotation { None, Up, Down, StatementBegin, StatementEnd };
+
+    // Recognises '-- +tama <word>' inside a line comment (the text after '--')
+    Annotation parse_annotation(std::string_view comment) {
+        auto start = comment.find_first_not_of(" \t");
+        if (start == npos) return Annotation::None;
+        comment.remove_prefix(start);
+
+        constexpr std::string_view prefix = "+tama";
+        if (!comment.starts_with(prefix)) return Annotation::None;
+        comment.remove_prefix(prefix.size());
+
+        auto word_start = comment.find_first_not_of(" \t");
+        if (word_start == 0 || word_start == npos) return Annotation::None;
+        comment.remove_prefix(word_start);
+
+        std::string word;
+        for (char c : comment) {
+            if (std::isspace(static_cast<unsigned char>(c))) break;
+            word += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        if (word == "up") return Annotation::Up;
+        if (word == "down") return Annotation::Down;
+        if (word == "statementbegin") return Annotation::StatementBegin;
+        if (word == "statementend") return Annotation::StatementEnd;
+        return Annotation::None;
+    }
+
+    // Reads the leading words of a statement: keywords and (possibly quoted) identifiers.
+    // Comments are skipped; anything else ('(', ',', literals) ends the head.
+    class HeadReader {
+    public:
+        explicit HeadReader(std::string_view text) : sql(text) {}
+
+        // Next word, unquoted, as a view into the statement. Empty when the head is over.
+        std::string_view next() {
+            skip_trivia();
+            if (pos >= sql.size()) return {};
+
+            char c = sql[pos];
+            if (c == '"' || c == '`' || c == '[') {
+                char closing = (c == '[') ? ']' : c;
+                auto end = sql.find(closing, pos + 1);
+                if (end == npos) end = sql.size();
+                auto word = sql.substr(pos + 1, end - pos - 1);
+                pos = std::min(end + 1, sql.size());
+                return word;
+            }
+
+            std::size_t start = pos;
+            while (pos < sql.size() && is_word_byte(sql[pos])) ++pos;
+            return sql.substr(start, pos - start);
+        }
+
+        // True once only whitespace and comments are left
+        bool at_end() {
+            skip_trivia();
+            return pos >= sql.size();
+        }
+
+        // Consumes a '.' if it comes next (schema.table)
+        bool dot() {
+            skip_trivia();
+            if (pos < sql.size() && sql[pos] == '.') {
+                ++pos;
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        std::string_view sql;
+        std::size_t pos = 0;
+
+        static bool is_word_byte(char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+        }
+
+        void skip_trivia() {
+            while (pos < sql.size()) {
+                if (std::isspace(static_cast<unsigned char>(sql[pos]))) {
+                    ++pos;
+                } else if (sql.substr(pos).starts_with("--")) {
+                    pos = sql.find('\n', pos);
+                    if (pos == npos) pos = sql.size();
+                } else if (sql.substr(pos).starts_with("/*")) {
+                    pos = sql.find("*/", pos + 2);
+                    pos = (pos == npos) ? sql.size() : pos + 2;
+                } else {
+                    return;
+                }
+            }
+        }
+    };
+
+    bool keyword_is(std::string_view word, std::string_view keyword) {
+        return std::ranges::equal(word, keyword, [](char a, char b) {
+            return std::toupper(static_cast<unsigned char>(a)) == b;
+        });
+    }
+
+    enum class Section { None, Up, Down };
+
+    /*
+       Single pass over the file. The lexer tracks just enough state to know whether a
+       byte is real SQL: string literals ('...'), quoted identifiers ("...", `...`, [...]),
+       line comments (-- ...) and block comments. Only ';' in plain code ends a
+       statement, and only '-- +tama' line comments in plain code are annotations.
+
+       A CREATE TRIGGER body holds ';'-terminated statements of its own, so a trigger
+       runs on until an 'END;' (the same rule sqlite3_complete() applies).
+    */
+    class Splitter {
+    public:
+        explicit Splitter(std::string_view text) : raw(text) {}
+
+        ParsedMigration run() {
+            std::size_t pos = 0;
+            const std::size_t n = raw.size();
+
+            while (pos < n) {
+                // Pin the start of the next statement on its first real code byte
+                if (stmt_start == npos && !in_block) {
+                    while (pos < n && std::isspace(static_cast<unsigned char>(raw[pos]))) ++pos;
+                    if (pos >= n) break;
+                    if (!starts_comment(pos)) stmt_start = pos;
+                }
+
+                pos = find_any(raw, pos, code_bytes);
+                if (pos >= n) break;
+
+                switch (raw[pos]) {
+                    case '\'': pos = skip_past(pos + 1, single_quote); break;
+                    case '"':  pos = skip_past(pos + 1, double_quote); break;
+                    case '`':  pos = skip_past(pos + 1, backtick); break;
+                    case '[':  pos = skip_past(pos + 1, close_bracket); break;
+                    case '-':
+                        pos = (pos + 1 < n && raw[pos + 1] == '-') ? line_comment(pos) : pos + 1;
+                        break;
+                    case '/':
+                        pos = (pos + 1 < n && raw[pos + 1] == '*') ? block_comment(pos) : pos + 1;
+                        break;
+                    case ';':
+                        if (!in_block) end_statement(pos);
+                        ++pos;
+                        break;
+                    default:
+                        ++pos;
+                }
+            }
+
+            close_section(n);
+            return std::move(result);
+        }
+
+    private:
+        std::string_view raw;
+        ParsedMigration result;
+
+        Section section = Section::None;
+        std::size_t section_start = 0;
+        bool seen_up = false;
+        bool seen_down = false;
+
+        std::size_t stmt_start = npos;
+        bool in_trigger = false;
+        std::size_t last_semicolon = 0; // Inside a trigger: the ';' before the current body statement
+        bool in_block = false;
+        std::size_t block_start = 0;
+
+        // Raw-file offsets of the statements in the current section
+        std::vector<SqlStatement> pending;
+        std::size_t line_cursor = 0;
+        std::size_t line_number = 1;
+
+        [[nodiscard]] bool starts_comment(std::size_t pos) const {
+            if (pos + 1 >= raw.size()) return false;
+            return (raw[pos] == '-' && raw[pos + 1] == '-') || (raw[pos] == '/' && raw[pos + 1] == '*');
+        }
+
+        // Skip to just after the closing byte. Unterminated tokens run to the end of file.
+        std::size_t skip_past(std::size_t pos, const ByteSet& closing) const {
+            pos = find_any(raw, pos, closing);
+            return pos < raw.size() ? pos + 1 : pos;
+        }
+
+        std::size_t block_comment(std::size_t pos) const {
+            pos += 2;
+            while (true) {
+                pos = find_any(raw, pos, star);
+                if (pos + 1 >= raw.size()) return raw.size();
+                if (raw[pos + 1] == '/') return pos + 2;
+                ++pos;
+            }
+        }
+
+        std::size_t line_comment(std::size_t pos) {
+            std::size_t eol = find_any(raw, pos, newline);
+            std::size_t next = eol < raw.size() ? eol + 1 : eol;
+
+            switch (parse_annotation(raw.substr(pos + 2, eol - pos - 2))) {
+                case Annotation::Up:
+                    if (!seen_up) {
+                        close_section(pos);
+                        open_section(Section::Up, next);
+                        seen_up = true;
+                    }
+                    break;
+                case Annotation::Down:
+                    if (!seen_down) {
+                        close_section(pos);
+                        open_section(Section::Down, next);
+                        seen_down = true;
+                    }
+                    break;
+                case Annotation::StatementBegin:
+                    if (!in_block) {
+                        flush_unterminated(pos);
+                        in_block = true;
+                        block_start = next;
+                    }
+                    break;
+                case Annotation::StatementEnd:
+                    if (in_block) {
+                        emit_trimmed(block_start, pos);
+                        in_block = false;
+                        stmt_start = npos;
+                    }
+                    break;
+                case Annotation::None:
+                    break;
+            }
+            return next;
+        }
+
+        void open_section(Section s, std::size_t start) {
+            section = s;
+            section_start = start;
+            stmt_start = npos;
+            in_trigger = false;
+        }
+
+        // Finish the current section at raw offset 'end': keep its text and
+        // rebase its statements onto it.
+        void close_section(std::size_t end) {
+            if (in_block) {
+                emit_trimmed(block_start, end);
+                in_block = false;
+            }
+            flush_unterminated(end);
+
+            if (section != Section::None) {
+                end = std::max(end, section_start);
+                std::string_view& sql = (section == Section::Up) ? result.up_sql : result.down_sql;
+                auto& statements = (section == Section::Up) ? result.up_statements : result.down_statements;
+
+                sql = raw.substr(section_start, end - section_start);
+                for (auto stmt : pending) {
+                    stmt.offset -= section_start;
+                    statements.push_back(stmt);
+                }
+            }
+            pending.clear();
+            section = Section::None;
+        }
+
+        // A ';' in plain code at 'pos'. Ends the statement, unless it only ends a
+        // statement inside a trigger body.
+        void end_statement(std::size_t pos) {
+            if (stmt_start == npos) return;
+
+            if (!in_trigger) {
+                in_trigger = starts_trigger(raw.substr(stmt_start, pos - stmt_start));
+            } else {
+                HeadReader body(raw.substr(last_semicolon + 1, pos - last_semicolon - 1));
+                in_trigger = !(keyword_is(body.next(), "END") && body.at_end());
+            }
+
+            if (in_trigger) {
+                last_semicolon = pos;
+                return;
+            }
+            emit(stmt_start, pos + 1);
+            stmt_start = npos;
+        }
+
+        static bool starts_trigger(std::string_view statement) {
+            HeadReader reader(statement);
+            if (!keyword_is(reader.next(), "CREATE")) return false;
+            auto word = reader.next();
+            if (keyword_is(word, "TEMP") || keyword_is(word, "TEMPORARY")) word = reader.next();
+            return keyword_is(word, "TRIGGER");
+        }
+
+        // A trailing statement without ';' still counts
+        void flush_unterminated(std::size_t end) {
+            if (stmt_start != npos) emit_trimmed(stmt_start, end);
+            stmt_start = npos;
+            in_trigger = false;
+        }
+
+        void emit_trimmed(std::size_t begin, std::size_t end) {
+            while (begin < end && std::isspace(static_cast<unsigned char>(raw[begin]))) ++begin;
+            while (end > begin && std::isspace(static_cast<unsigned char>(raw[end - 1]))) --end;
+            if (begin < end) emit(begin, end);
+        }
+
+        void emit(std::size_t begin, std::size_t end) {
+            if (section == Section::None) return; // SQL before '-- +tama up' is ignored
+
+            // Statements arrive in file order, so line numbers are counted incrementally
+            line_number += static_cast<std::size_t>(
+                std::count(raw.begin() + static_cast<std::ptrdiff_t>(line_cursor),
+                           raw.begin() + static_cast<std::ptrdiff_t>(begin), '\n'));
+            line_cursor = begin;
+
+            pending.push_back({begin, end - begin, line_number});
+        }
+    };
+
+    // Reads '[schema.]name' and drops the schema, ANALYZE runs against 'main' anyway
+    std::optional<std::string_view> read_table_name(HeadReader& reader) {
+        std::string_view name = reader.next();
+        while (!name.empty() && reader.dot()) name = reader.next();
+        if (name.empty()) return std::nullopt;
+        return name;
+    }
+} // namespace
 
 ParsedMigration Parser::parse(std::string_view raw_content) {
-    ParsedMigration result;
+    return Splitter(raw_content).run();
+}
+
+std::optional<std::string_view> Parser::target_table(std::string_view statement) {
+    HeadReader reader(statement);
+    std::string_view word = reader.next();
 
-    // Define the markers we are looking for
-    constexpr std::string_view up_marker = "-- +tama up";
-    constexpr std::string_view down_marker = "-- +tama down";
+    // INSERT/REPLACE [OR <conflict>] INTO name
+    if (keyword_is(word, "INSERT") || keyword_is(word, "REPLACE")) {
+        while (!(word = reader.next()).empty()) {
+            if (keyword_is(word, "INTO")) return read_table_name(reader);
+        }
+        return std::nullopt;
+    }
+
+    // UPDATE [OR <conflict>] name
+    if (keyword_is(word, "UPDATE")) {
+        word = reader.next();
+        if (keyword_is(word, "OR")) {
+            reader.next(); // conflict clause (ROLLBACK, ABORT, ...)
+            return read_table_name(reader);
+        }
+        while (!word.empty() && reader.dot()) word = reader.next();
+        if (word.empty()) return std::nullopt;
+        return word;
+    }
 
-    // 1. Find the UP section
-    size_t up_pos = raw_content.find(up_marker);
-    size_t down_pos = raw_content.find(down_marker);
+    // DELETE FROM name
+    if (keyword_is(word, "DELETE")) {
+        if (!keyword_is(reader.next(), "FROM")) return std::nullopt;
+        return read_table_name(reader);
+    }
 
-    // If no UP marker found, return empty result
-    if (up_pos == std::string_view::npos) {
-        return result;
+    // ALTER TABLE name
+    if (keyword_is(word, "ALTER")) {
+        if (!keyword_is(reader.next(), "TABLE")) return std::nullopt;
+        return read_table_name(reader);
     }
 
-    // Start reading *after* the UP marker
-    size_t up_start = up_pos + up_marker.size();
+    // CREATE [TEMP] TABLE [IF NOT EXISTS] name
+    // CREATE [UNIQUE] INDEX [IF NOT EXISTS] name ON table
+    if (keyword_is(word, "CREATE")) {
+        word = reader.next();
+        if (keyword_is(word, "TEMP") || keyword_is(word, "TEMPORARY") || keyword_is(word, "UNIQUE")) {
+            word = reader.next();
+        }
 
-    // The UP section ends at the DOWN marker 
-    size_t up_end = (down_pos == std::string_view::npos) ? raw_content.size() : down_pos;
+        bool is_table = keyword_is(word, "TABLE");
+        bool is_index = keyword_is(word, "INDEX");
+        if (!is_table && !is_index) return std::nullopt;
 
-    // Extract UP block
-    result.up_sql = raw_content.substr(up_start, up_end - up_start);
+        word = reader.next();
+        if (keyword_is(word, "IF")) {
+            reader.next(); // NOT
+            reader.next(); // EXISTS
+            word = reader.next();
+        }
+        while (!word.empty() && reader.dot()) word = reader.next();
+        if (word.empty()) return std::nullopt;
+        if (is_table) return word;
 
-    // 2. Find the DOWN section (if it exists)
-    if (down_pos != std::string_view::npos) {
-        size_t down_start = down_pos + down_marker.size();
-        result.down_sql = raw_content.substr(down_start);
+        if (!keyword_is(reader.next(), "ON")) return std::nullopt;
+        return read_table_name(reader);
     }
 
-    return result;
+    return std::nullopt;
 }
@@ -1,13 +1,40 @@
 #pragma once
+#include <cstddef>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
+// One executable unit inside a section. Offsets point into the section's SQL
+// (up_sql / down_sql), so the statement text is section.substr(offset, length).
+struct SqlStatement {
+    std::size_t offset = 0;
+    std::size_t length = 0;
+    std::size_t line = 0; // 1-based line in the migration file, for diagnostics
+};
+
+// The sections are views into the content passed to Parser::parse (no copies, so a
+// multi-GB seed file is held in memory once). Keep that content alive while using them.
 struct ParsedMigration {
-    std::string up_sql;
-    std::string down_sql;
+    std::string_view up_sql;
+    std::string_view down_sql;
+
+    std::vector<SqlStatement> up_statements;
+    std::vector<SqlStatement> down_statements;
 };
 
 class Parser {
 public:
+    // Lexes the migration file (quotes, identifiers, comments, annotations) and
+    // splits each section into statements (a CREATE TRIGGER runs up to its 'END;').
+    // Understands these annotations:
+    //   -- +tama up / -- +tama down                   section markers
+    //   -- +tama statementbegin / -- +tama statementend  keep the body as one statement
     static ParsedMigration parse(std::string_view raw_content);
-};
\ No newline at end of file
+
+    // The table a single statement writes to or reshapes (CREATE TABLE/INDEX, ALTER,
+    // INSERT/REPLACE, UPDATE, DELETE), read from the statement head only.
+    // Returns nullopt for anything else (DROP, SELECT, triggers, CTEs, ...).
+    // The name is a view into 'statement' (unquoted), so this does not allocate.
+    static std::optional<std::string_view> target_table(std::string_view statement);
+};
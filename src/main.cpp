@@ -1,13 +1,50 @@
 #include "handlers.hpp"
+#include "config.hpp"
+#include "logger.hpp"
 #include <map>
 #include <functional>
-#include <print>
 #include <cstdlib>
+#include <exception>
 #include <span>
 #include <string_view>
 #include <vector>
 #include "internals/Commands/handlers.hpp"
 
+namespace {
+    // Logging is configured before dispatch: .env values first, then CLI flags win.
+    // A missing .env is fine here, the command handlers report that themselves.
+    logger::Options logging_options_from_env() {
+        logger::Options options;
+        auto env = config::load_env(".env");
+        if (!env) return options;
+
+        if (env->contains("TAMA_LOG_LEVEL")) {
+            options.level = logger::parse_level(env->at("TAMA_LOG_LEVEL")).value_or(options.level);
+        }
+        if (env->contains("TAMA_LOG_FORMAT")) {
+            options.format = logger::parse_format(env->at("TAMA_LOG_FORMAT")).value_or(options.format);
+        }
+        if (env->contains("TAMA_LOG_ASYNC")) {
+            options.async = config::is_true(env->at("TAMA_LOG_ASYNC"));
+        }
+        return options;
+    }
+
+    // Returns true if 'arg' was a global logging flag (and consumes it)
+    bool apply_logging_flag(std::string_view arg, logger::Options& options) {
+        if (arg == "-q" || arg == "--quiet") {
+            options.level = logger::Level::Error;
+        } else if (arg == "-v" || arg == "--verbose") {
+            options.level = logger::Level::Debug;
+        } else if (arg == "--json") {
+            options.format = logger::Format::Json;
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
+
 int main(int argc, char *argv[]) {
     // 1. Wrap the raw C-array in a std::span
     // This creates a safe "view" over the arguments
@@ -15,17 +52,23 @@ int main(int argc, char *argv[]) {
 
     // 2. Convert to a vector of string_views for easier handling (Optional but nice)
     // We skip the first argument (args_view[0]) because it's just the program name.
+    // Global logging flags (--quiet, --verbose, --json) are stripped out here.
+    logger::Options log_options = logging_options_from_env();
     std::vector<std::string_view> args;
     if (args_view.size() > 1) {
         for (auto arg : args_view.subspan(1)) {
-            args.emplace_back(arg);
+            if (!apply_logging_flag(arg, log_options)) {
+                args.emplace_back(arg);
+            }
         }
     }
+    logger::init(log_options);
 
     // 3. Simple Router Logic
     if (args.empty()) {
-        std::println("Error: No command provided.");
+        logger::error("Error: No command provided.");
         commands::handle_help({});
+        logger::shutdown();
         return 1;
     }
 
@@ -38,6 +81,8 @@ int main(int argc, char *argv[]) {
         { "up",   commands::handle_up },
         { "down", commands::handle_down },
         { "reset", commands::handle_reset },
+        { "restore", commands::handle_restore },
+        { "stats", commands::handle_stats },
     };
 
     // 4. Router Logic
@@ -49,12 +94,22 @@ int main(int argc, char *argv[]) {
         std::span<std::string_view> cmd_args(args.begin() + 1, args.end());
         
         // Execute!
-        dispatch_table.at(command)(cmd_args);
+        // Migrator throws if the DB cannot be opened; report it through the logger
+        // so buffered output is flushed instead of lost in std::terminate.
+        try {
+            dispatch_table.at(command)(cmd_args);
+        } catch (const std::exception& e) {
+            logger::error("Error: {}", e.what());
+            logger::shutdown();
+            return 1;
+        }
     } else {
-        std::println("Unknown command: '{}'", command);
+        logger::error("Unknown command: '{}'", command);
         commands::handle_help({});
+        logger::shutdown();
         return 1;
     }
 
+    logger::shutdown();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+// Parser tests: section markers, statement splitting and the lexer's edge cases.
+// Built once per scan path (scalar, SSE2/NEON, AVX2), see tests/CMakeLists.txt.
+#include "parser.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void check(bool ok, std::string_view what) {
+        if (!ok) {
+            std::fprintf(stderr, "FAIL: %.*s\n", static_cast<int>(what.size()), what.data());
+            failures++;
+        }
+    }
+
+    std::vector<std::string_view> statements(std::string_view sql, const std::vector<SqlStatement>& list) {
+        std::vector<std::string_view> out;
+        for (const auto& stmt : list) out.push_back(sql.substr(stmt.offset, stmt.length));
+        return out;
+    }
+
+    std::vector<std::string_view> up(const ParsedMigration& parsed) {
+        return statements(parsed.up_sql, parsed.up_statements);
+    }
+
+    std::vector<std::string_view> down(const ParsedMigration& parsed) {
+        return statements(parsed.down_sql, parsed.down_statements);
+    }
+
+    void test_sections() {
+        std::string file = "-- +tama up\nCREATE TABLE a(x);\n\n-- +tama down\nDROP TABLE a;\n";
+        auto parsed = Parser::parse(file);
+        check(up(parsed) == std::vector<std::string_view>{"CREATE TABLE a(x);"}, "sections: up");
+        check(down(parsed) == std::vector<std::string_view>{"DROP TABLE a;"}, "sections: down");
+        check(parsed.down_statements.at(0).line == 5, "sections: line numbers");
+    }
+
+    // '-- +tama down' is only an annotation in plain code
+    void test_annotation_in_literals_and_comments() {
+        std::string file =
+            "-- +tama up\n"
+            "INSERT INTO t VALUES ('\n-- +tama down\n');\n"
+            "CREATE TABLE \"\n-- +tama down\n\"(x);\n"
+            "/*\n-- +tama down\n*/\n"
+            "SELECT 1;\n"
+            "-- +tama down\n"
+            "SELECT 2;\n";
+        auto parsed = Parser::parse(file);
+        check(up(parsed).size() == 3, "literals: three up statements");
+        check(down(parsed) == std::vector<std::string_view>{"SELECT 2;"}, "literals: down starts at the real marker");
+    }
+
+    void test_quote_escapes() {
+        auto parsed = Parser::parse("-- +tama up\nINSERT INTO t VALUES ('it''s; fine', \"a\"\"b;\");\nSELECT 1;");
+        check(up(parsed) == std::vector<std::string_view>{
+                  "INSERT INTO t VALUES ('it''s; fine', \"a\"\"b;\");", "SELECT 1;"},
+              "escapes: doubled quotes do not end the literal");
+
+        parsed = Parser::parse("-- +tama up\nSELECT [a;b], `c;d` FROM t;\nSELECT 2;");
+        check(up(parsed).size() == 2, "escapes: bracket and backtick identifiers");
+    }
+
+    void test_annotated_block() {
+        std::string file =
+            "-- +tama up\n"
+            "SELECT 1;\n"
+            "-- +tama statementbegin\n"
+            "CREATE VIEW v AS SELECT 1; SELECT 2;\n"
+            "-- +tama statementend\n"
+            "SELECT 3;\n";
+        auto parsed = Parser::parse(file);
+        check(up(parsed) == std::vector<std::string_view>{
+                  "SELECT 1;", "CREATE VIEW v AS SELECT 1; SELECT 2;", "SELECT 3;"},
+              "block: kept as one statement");
+    }
+
+    void test_trigger() {
+        std::string file =
+            "-- +tama up\n"
+            "CREATE TEMP TRIGGER t AFTER INSERT ON a BEGIN\n"
+            "  UPDATE b SET y = CASE WHEN 1 THEN 2 END;\n"
+            "  DELETE FROM c;\n"
+            "END;\n"
+            "SELECT 1;\n";
+        auto parsed = Parser::parse(file);
+        auto list = up(parsed);
+        check(list.size() == 2, "trigger: body stays in one statement");
+        check(!list.empty() && list[0].ends_with("END;"), "trigger: runs up to END;");
+    }
+
+    // Unterminated tokens run to the end of the file instead of reading past it
+    void test_unterminated() {
+        check(up(Parser::parse("-- +tama up\nSELECT 'open; -- +tama down\n")).size() == 1, "unterminated: string");
+        check(up(Parser::parse("-- +tama up\nSELECT \"open;")).size() == 1, "unterminated: identifier");
+        check(up(Parser::parse("-- +tama up\nSELECT 1; /* open; -- +tama down")).size() == 1, "unterminated: block comment");
+        check(up(Parser::parse("-- +tama up\nSELECT 1")) == std::vector<std::string_view>{"SELECT 1"},
+              "unterminated: statement without ';'");
+        check(down(Parser::parse("-- +tama up\nSELECT 1;\n-- +tama down")).empty(), "unterminated: empty down");
+    }
+
+    // Moves the interesting byte across every offset of the 16/32-byte scan windows
+    void test_long_inputs() {
+        for (std::size_t pad = 0; pad < 100; ++pad) {
+            std::string filler(pad, 'x');
+            std::string first = "SELECT '" + filler + ";';";
+            std::string second = "SELECT \"" + filler + "\" /* " + filler + "; */;";
+            std::string file = "-- +tama up\n" + first + "\n" + second + "\n-- " + filler + "\n-- +tama down\nSELECT 3;";
+
+            auto parsed = Parser::parse(file);
+            bool ok = up(parsed) == std::vector<std::string_view>{first, second} &&
+                      down(parsed) == std::vector<std::string_view>{"SELECT 3;"};
+            if (!ok) {
+                check(false, "long inputs: padding " + std::to_string(pad));
+                return;
+            }
+        }
+    }
+
+    void test_target_table() {
+        check(Parser::target_table("INSERT OR REPLACE INTO main.\"Users\" VALUES (1)") == "Users", "target: insert");
+        check(Parser::target_table("update t set x = 1") == "t", "target: update");
+        check(Parser::target_table("CREATE UNIQUE INDEX IF NOT EXISTS i ON [t](x)") == "t", "target: index");
+        check(Parser::target_table("/* c */ DELETE FROM t") == "t", "target: comment before head");
+        check(!Parser::target_table("DROP TABLE t"), "target: drop");
+    }
+}
+
+int main() {
+    test_sections();
+    test_annotation_in_literals_and_comments();
+    test_quote_escapes();
+    test_annotated_block();
+    test_trigger();
+    test_unterminated();
+    test_long_inputs();
+    test_target_table();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}